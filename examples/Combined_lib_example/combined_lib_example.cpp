@@ -64,8 +64,7 @@ void setup() {
     semaphore_handle = xSemaphoreCreateBinary();
 
     // Init sensors according to payload_port selected
-    // Neither 1901 or 1906 is needed for PORT1
-    if (!initSensors(&payload_port, false, false)) {
+    if (!initSensors(&payload_port)) {
         // error init-ing sensors
         delay(1000);
         return;
@@ -68,6 +68,14 @@ void sendLoRaWANFrame(lmh_app_data_t *lora_app_data) {
         return;
     }
 
+    // lmh_send() would fail anyway, after the wake up and radio setup
+    uint8_t max_payload_size = queryLoRaWANMaxPayloadSize();
+    if (lora_app_data->buffsize > max_payload_size) {
+        log(LOG_LEVEL::ERROR, "Payload of %d bytes is too long for the datarate (max %d bytes).", lora_app_data->buffsize,
+            max_payload_size);
+        return;
+    }
+
     log(LOG_LEVEL::DEBUG, "Sending payload frame now...");
     lmh_error_status ret = lmh_send(lora_app_data, loraConfirm);
     if (ret == LMH_SUCCESS) {
@@ -79,6 +87,55 @@ void sendLoRaWANFrame(lmh_app_data_t *lora_app_data) {
     }
 }
 
+uint8_t getLoRaWANDatarate(void) {
+    MibRequestConfirm_t mib_request;
+    mib_request.Type = MIB_CHANNELS_DATARATE;
+    LoRaMacMibGetRequestConfirm(&mib_request);
+    return (uint8_t)mib_request.Param.ChannelsDatarate;
+}
+
+/** @brief Max application payload (N) of each uplink datarate DR_0 - DR_7 of a region, 0 if not an uplink one. */
+struct regionPayloadSizes {
+    LoRaMacRegion_t region;
+    uint8_t no_dwell_time[8]; /**< Uplink dwell time 0 (no limit). */
+    uint8_t dwell_time[8];    /**< Uplink dwell time 1 (400 ms). */
+};
+
+// as in the LoRaWAN regional parameters, EU868 has no dwell time limit and US915 always has it
+static const regionPayloadSizes region_payload_sizes[] = {
+    { LORAMAC_REGION_AU915, { 51, 51, 51, 115, 242, 242, 242, 0 }, { 0, 0, 11, 53, 125, 242, 242, 0 } },
+    { LORAMAC_REGION_AS923, { 51, 51, 51, 115, 242, 242, 242, 242 }, { 0, 0, 11, 53, 125, 242, 242, 242 } },
+    { LORAMAC_REGION_EU868, { 51, 51, 51, 115, 242, 242, 242, 242 }, { 51, 51, 51, 115, 242, 242, 242, 242 } },
+    { LORAMAC_REGION_US915, { 11, 53, 125, 242, 242, 0, 0, 0 }, { 11, 53, 125, 242, 242, 0, 0, 0 } },
+};
+
+uint8_t maxLoRaWANPayloadSize(uint8_t datarate, bool uplink_dwell_time) {
+    if (datarate >= sizeof(region_payload_sizes[0].no_dwell_time)) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < (sizeof(region_payload_sizes) / sizeof(region_payload_sizes[0])); i++) {
+        if (region_payload_sizes[i].region == loraRegion) {
+            return uplink_dwell_time ? region_payload_sizes[i].dwell_time[datarate]
+                                     : region_payload_sizes[i].no_dwell_time[datarate];
+        }
+    }
+    log(LOG_LEVEL::WARN, "No max payload table for LoRaWAN region %d.", loraRegion);
+    return 0;
+}
+
+uint8_t queryLoRaWANMaxPayloadSize(void) {
+    // the MAC knows the region, the datarate of the next uplink, the dwell time the network set & any MAC commands
+    // (FOpts) waiting to go with it
+    LoRaMacTxInfo_t tx_info;
+    LoRaMacQueryTxPossible(0, &tx_info);
+    return tx_info.MaxPossiblePayload;
+}
+
+uint8_t getLoRaWANMaxPayloadSize(void) {
+    uint8_t max_payload_size = queryLoRaWANMaxPayloadSize();
+    return (max_payload_size < PAYLOAD_BUFFER_SIZE) ? max_payload_size : PAYLOAD_BUFFER_SIZE;
+}
+
 /**
  * @brief LoRa function for handling HasJoined event.
  * Sends LoRa class change and starts app timer to send the payload periodically.
@@ -58,6 +58,7 @@ inline void startLoRaWANJoinProcedure(void) {
 
 /**
  * @brief Sends a frame with the data provided.
+ * Frames that are too long for the current datarate aren't sent, see getLoRaWANMaxPayloadSize().
  * @param lora_app_data Data to be sent.
  */
 void sendLoRaWANFrame(lmh_app_data_t *lora_app_data);
@@ -70,6 +71,34 @@ inline bool isLoRaWANConnected(void) {
     return (lmh_join_status_get() == LMH_SET);
 };
 
+/**
+ * @brief Gets the datarate uplinks are currently sent at.
+ * @return Datarate, DR_0 to DR_6 for AU915.
+ */
+uint8_t getLoRaWANDatarate(void);
+
+/**
+ * @brief Gets the max application payload of the given datarate for loraRegion, from the regional parameters.
+ * Doesn't count any MAC commands sent along with the payload, use queryLoRaWANMaxPayloadSize() for the next uplink.
+ * @param datarate Datarate, DR_0 to DR_6 for AU915.
+ * @param uplink_dwell_time True if the 400 ms uplink dwell time limit applies (AS923 & AU915, set by the network).
+ * @return Max payload length in bytes, or 0 if the datarate isn't valid for uplinks (or the region isn't tabled).
+ */
+uint8_t maxLoRaWANPayloadSize(uint8_t datarate, bool uplink_dwell_time = false);
+
+/**
+ * @brief Asks the MAC for the max application payload of the next uplink, as checked by lmh_send().
+ * Goes by loraRegion, the datarate (after any ADR change), the uplink dwell time & the MAC commands waiting to be sent.
+ * @return Max payload length in bytes.
+ */
+uint8_t queryLoRaWANMaxPayloadSize(void);
+
+/**
+ * @brief Gets the max application payload of the next uplink that also fits the payload buffer.
+ * @return Max payload length in bytes, at most PAYLOAD_BUFFER_SIZE.
+ */
+uint8_t getLoRaWANMaxPayloadSize(void);
+
 /**
  * @brief Sets the class to loraClass.
  * @return True if successful, false if not.
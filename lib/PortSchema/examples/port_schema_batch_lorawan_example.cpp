@@ -0,0 +1,112 @@
+/**
+ * @file main.cpp
+ * @author Kalina Knight
+ * @brief An example of batching several sensor data samples into each LoRaWAN uplink with BatchPortEncoder.
+ * Fake current sensor data is sampled every 5 seconds, and once a payload of the current datarate is full (or 30 seconds
+ * have passed) the buffered samples are sent together in one uplink. So the current is seen at a finer time
+ * resolution without waking the radio for every reading.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+#include <LoRaWan-RAK4630.h> // Click to get library: https://platformio.org/lib/show/6601/SX126x-Arduino
+
+#include "BatchPortEncoding.h" /**< Go here to change the max samples buffered. */
+#include "LoRaWAN_functs.h"    /**< Go here to provide the OTAA keys & change the LoRaWAN settings. */
+#include "Logging.h"           /**< Go here to change the logging level for the entire application. */
+#include "OTAA_keys.h"         /**< Go here to set the OTAA keys (See LoRaWAN_functs README). */
+#include "PortSchema.h"        /**< Go here to see existing and define new sensor/port schemas. */
+
+// PORT/SENSOR SELECTION
+// A batched port needs its own port number, so the decoder knows to expect a batch payload
+static constexpr portSchema PORT_BATCH = { 110, SEND_BATTERY_VOLTAGE | SEND_CURRENT_SENSOR, PAYLOAD_FORMAT::BIT_PACKED };
+BatchPortEncoder batch_encoder(PORT_BATCH);
+
+// fill with fake data, making sure to set the validity flag to true
+sensorData sensor_data = { 3900, true, 0, false, 0, false, 0, false, 0, false, 0, 0, false, 12.5, true, 2048 };
+
+const int sample_interval = 5000;  /**< Sensor reading interval in [ms] = 5 seconds. */
+const int uplink_interval = 30000; /**< Longest time between uplinks in [ms] = 30 seconds. */
+unsigned long last_uplink = 0;
+
+// PAYLOAD ENCODING
+uint8_t payload_buffer[PAYLOAD_BUFFER_SIZE] = {};                /**< Buffer that payload data is placed in. */
+lmh_app_data_t lorawan_payload = { payload_buffer, 0, 0, 0, 0 }; /**< Struct that passes the payload buffer and relevant
+                                                                    params for a LoRaWAN frame. */
+// forward declaration
+void fillPayload(void);
+
+/**
+ * @brief Setup code runs once on reset/startup.
+ */
+void setup() {
+    // initialise the logging module - function does nothing if APP_LOG_LEVEL in Logging.h = NONE
+    initLogging();
+    log(LOG_LEVEL::INFO,
+        "\n============================================"
+        "\nWelcome to Port Schema Batch LoRaWAN Example"
+        "\n============================================");
+
+    // Init LoRaWAN
+    if (!initLoRaWAN(OTAA_KEY_APP_EUI, OTAA_KEY_DEV_EUI, OTAA_KEY_APP_KEY)) {
+        return;
+    }
+
+    // Attempt to join the network
+    startLoRaWANJoinProcedure();
+}
+
+/**
+ * @brief Loop code runs repeated after setup().
+ */
+void loop() {
+    // every sample_interval ms take a sample
+    delay(sample_interval);
+    sensor_data.current_A.value += random(-50, 51) / 100.0;
+    batch_encoder.addSample(&sensor_data, millis() / 1000);
+
+    // send once a payload is full or uplink_interval ms have passed
+    uint8_t max_payload_size = getLoRaWANMaxPayloadSize();
+    if ((batch_encoder.samplesWaiting() < batch_encoder.samplesPerPayload(max_payload_size)) &&
+        ((millis() - last_uplink) < uplink_interval)) {
+        return;
+    }
+
+    if (isLoRaWANConnected()) {
+        log(LOG_LEVEL::DEBUG, "Send payload");
+        // fill lora data buffer
+        fillPayload();
+        // send data
+        sendLoRaWANFrame(&lorawan_payload);
+        last_uplink = millis();
+    } else {
+        log(LOG_LEVEL::DEBUG, "LoRaWAN not connected. Try again later.");
+    }
+}
+
+/**
+ * @brief Fills payload_buffer with as many of the buffered samples as fit in the max payload of the current datarate,
+ * ready for sending via LoRaWAN.
+ */
+void fillPayload(void) {
+    // reset the payload
+    memset(payload_buffer, 0, sizeof(payload_buffer));
+    lorawan_payload.buffsize = 0;
+    lorawan_payload.port = PORT_BATCH.port_number;
+
+    // encode the samples to lorawan_payload
+    uint8_t samples_waiting = batch_encoder.samplesWaiting();
+    lorawan_payload.buffsize = batch_encoder.encodeBatchToPayload(payload_buffer, getLoRaWANMaxPayloadSize());
+
+    // log the encoded bytes
+    char encoded_payload_bytes[3 * PAYLOAD_BUFFER_SIZE] = {};
+    for (int b = 0; b < lorawan_payload.buffsize; b++) {
+        snprintf(encoded_payload_bytes, sizeof(encoded_payload_bytes), "%s%02X ", encoded_payload_bytes, payload_buffer[b]);
+    }
+    log(LOG_LEVEL::INFO, "Port: %2.d | Samples: %d | Payload: %s", lorawan_payload.port,
+        samples_waiting - batch_encoder.samplesWaiting(), encoded_payload_bytes);
+}
@@ -0,0 +1,279 @@
+/**
+ * @file main.cpp
+ * @author Kalina Knight
+ * @brief A benchmark of the sensor port schema encoding and decoding.
+ * Compares the cycle count of the original double-precision encode/decode (copied below as the "legacy" path) to the
+ * fixed-point path now used by sensorPortSchema, for every sensor schema defined in SensorPortSchema.h (a sensor
+ * field whose schema has no row in schema_benchmarks fails to compile).
+ * Then compares encoding a full PORT59 payload with the runtime portSchema to the compile time PortCodec, with all
+ * valid and all invalid data. The PortCodec encoding is branch-free so it takes the same cycles either way.
+ * Finally reports the payload length of every registered port in the FIXED and BIT_PACKED payload formats.
+ * Uses the DWT cycle counter of the Cortex-M4F, so the results are in CPU cycles (64 MHz on the nRF52840).
+ * This example does not use LoRa at all, it only prints the results.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+
+#include "Logging.h"    /**< Go here to change the logging level for the entire application. */
+#include "PortSchema.h" /**< Go here to see existing and define new sensor/port schemas. */
+
+// Number of times each encode/decode is repeated, the cycle count is averaged over these.
+#define BENCHMARK_ITERATIONS 1000
+
+/**
+ * @brief The original double-precision encode, kept here as the reference for the benchmark.
+ * noinline so that, like sensorPortSchema::encodeData(), the scaling can't be hoisted out of the benchmark loop.
+ */
+template <typename T>
+__attribute__((noinline)) uint8_t legacyEncodeData(T sensor_data, bool valid, uint8_t *payload_buffer, uint8_t buf_pos, const sensorPortSchema *sensor_schema) {
+    long long data_to_encode = 0;
+    if (valid) {
+        data_to_encode = (long long)((double)sensor_data * (double)sensor_schema->scaleFactor());
+    } else if (sensor_schema->is_signed) {
+        data_to_encode = 0x7F7F7F7F;
+    } else {
+        data_to_encode = 0xFFFFFFFF;
+    }
+
+    int data_size = sensor_schema->n_bytes / sensor_schema->n_values;
+    uint8_t i = 0;
+    uint8_t j = (data_size - 1);
+    for (; i < data_size; i++, j--) {
+        uint8_t bitshift = j * 8;
+        if (j > 0) {
+            payload_buffer[buf_pos + i] = (uint8_t)((data_to_encode & (0xFF << bitshift)) >> bitshift);
+        } else {
+            payload_buffer[buf_pos + i] = (uint8_t)(data_to_encode & 0xFF);
+        }
+    }
+    return (buf_pos + i);
+}
+
+/**
+ * @brief The original double-precision decode, kept here as the reference for the benchmark.
+ */
+template <typename T>
+__attribute__((noinline)) uint8_t legacyDecodeData(T *sensor_data, bool *valid, uint8_t *buffer, uint8_t buf_pos, const sensorPortSchema *sensor_schema) {
+    long long data_to_decode = 0;
+    int data_size = sensor_schema->n_bytes / sensor_schema->n_values;
+    uint8_t i = 0;
+    uint8_t j = (data_size - 1);
+    for (; i < data_size; i++, j--) {
+        uint8_t bitshift = j * 8;
+        if (j > 0) {
+            data_to_decode += (long long)(buffer[buf_pos + i] << bitshift);
+        } else {
+            data_to_decode += (long long)(buffer[buf_pos + i]);
+        }
+    }
+
+    if ((sensor_schema->is_signed && (data_to_decode == 0x7F7F7F7F)) || (data_to_decode == 0xFFFFFFFF)) {
+        *valid = false;
+    } else {
+        *valid = true;
+        *sensor_data = (T)(((double)data_to_decode) / (double)sensor_schema->scaleFactor());
+    }
+    return (buf_pos + i);
+}
+
+/** @brief A sensor schema to benchmark, with a typical value of the type it is normally given. */
+struct schemaBenchmark {
+    const char *name;
+    const sensorPortSchema *schema;
+    bool is_float; /**< Use float_value if true, otherwise uint_value. */
+    float float_value;
+    uint32_t uint_value;
+};
+
+static constexpr schemaBenchmark schema_benchmarks[] = {
+    { "timestamp", &timestampSchema, false, 0, 1629763200 },
+    { "timeOffset", &timeOffsetSchema, false, 0, 42 },
+    { "batteryVoltage", &batteryVoltageSchema, true, 3712.0, 0 },
+    { "temperature", &temperatureSchema, true, -12.34, 0 },
+    { "relativeHumidity", &relativeHumiditySchema, true, 56.7, 0 },
+    { "airPressure", &airPressureSchema, false, 0, 101325 },
+    { "gasResistance", &gasResistanceSchema, false, 0, 123456 },
+    { "location", &locationSchema, true, -33.9173, 0 },
+    { "currentSensor", &currentSensorSchema, true, 12.34, 0 },
+    { "acCurrent", &acCurrentSchema, true, 5.67, 0 },
+    { "harmonics", &harmonicsSchema, true, 3.21, 0 },
+    { "thd", &thdSchema, true, 12.34, 0 },
+};
+#define SCHEMA_BENCHMARK_LENGTH (sizeof(schema_benchmarks) / sizeof(schema_benchmarks[0]))
+
+/**
+ * @brief Checks a sensor schema has a row in schema_benchmarks.
+ */
+constexpr bool hasSchemaBenchmark(const sensorPortSchema *schema, size_t row = 0) {
+    return (row < SCHEMA_BENCHMARK_LENGTH) &&
+           ((schema_benchmarks[row].schema == schema) || hasSchemaBenchmark(schema, row + 1));
+}
+
+/**
+ * @brief Checks the schema of every sensor field, from field f on, has a row in schema_benchmarks.
+ */
+constexpr bool everyFieldBenchmarked(uint8_t f = 0) {
+    return (f >= (uint8_t)SENSOR_FIELD::COUNT) ||
+           (hasSchemaBenchmark(SENSOR_FIELDS[f].schema) && everyFieldBenchmarked(f + 1));
+}
+static_assert(everyFieldBenchmarked(), "Every sensor field's schema needs a row in schema_benchmarks.");
+
+uint8_t payload_buffer[PortCodec<PORT59.sensor_mask>::PAYLOAD_LENGTH] = {};
+volatile float decoded_float;       // volatile so the decode isn't optimised away
+volatile uint32_t decoded_uint;     // volatile so the decode isn't optimised away
+
+/**
+ * @brief Start the DWT cycle counter.
+ */
+void initCycleCounter(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Benchmarks one sensor schema and logs the average cycles per encode & decode of both paths.
+ * @param bench Sensor schema to benchmark.
+ */
+void runSchemaBenchmark(const schemaBenchmark *bench) {
+    const sensorPortSchema *schema = bench->schema;
+    float f_value = 0;
+    uint32_t u_value = 0;
+    bool valid = false;
+    uint32_t start = 0;
+
+    // Legacy encode
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        if (bench->is_float) {
+            legacyEncodeData(bench->float_value, true, payload_buffer, 0, schema);
+        } else {
+            legacyEncodeData(bench->uint_value, true, payload_buffer, 0, schema);
+        }
+    }
+    uint32_t legacy_encode_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+
+    // Legacy decode
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        if (bench->is_float) {
+            legacyDecodeData(&f_value, &valid, payload_buffer, 0, schema);
+            decoded_float = f_value;
+        } else {
+            legacyDecodeData(&u_value, &valid, payload_buffer, 0, schema);
+            decoded_uint = u_value;
+        }
+    }
+    uint32_t legacy_decode_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+
+    // Fixed-point encode
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        if (bench->is_float) {
+            schema->encodeData(bench->float_value, true, payload_buffer, 0);
+        } else {
+            schema->encodeData(bench->uint_value, true, payload_buffer, 0);
+        }
+    }
+    uint32_t fixed_encode_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+
+    // Fixed-point decode
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        if (bench->is_float) {
+            schema->decodeData(&f_value, &valid, payload_buffer, 0);
+            decoded_float = f_value;
+        } else {
+            schema->decodeData(&u_value, &valid, payload_buffer, 0);
+            decoded_uint = u_value;
+        }
+    }
+    uint32_t fixed_decode_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+
+    log(LOG_LEVEL::INFO, "%-16s | encode: %4lu -> %4lu cycles | decode: %4lu -> %4lu cycles", bench->name,
+        legacy_encode_cycles, fixed_encode_cycles, legacy_decode_cycles, fixed_decode_cycles);
+}
+
+/**
+ * @brief Benchmarks encoding a full PORT59 payload and logs the average cycles per payload.
+ * @param sensor_data Sensor data to encode.
+ * @param description Description of the sensor data for the log.
+ */
+void runPortBenchmark(const sensorData *sensor_data, const char *description) {
+    sensorData data = *sensor_data;
+    uint32_t start = 0;
+
+    // Runtime portSchema
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        PORT59.encodeSensorDataToPayload(&data, payload_buffer);
+        __asm__ volatile("" ::: "memory"); // stop the compiler reusing the encoding from the previous iteration
+    }
+    uint32_t runtime_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+
+    // Compile time PortCodec
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        PortCodec<PORT59.sensor_mask>::encodeSensorDataToPayload(&data, payload_buffer);
+        __asm__ volatile("" ::: "memory"); // stop the compiler reusing the encoding from the previous iteration
+    }
+    uint32_t codec_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+
+    log(LOG_LEVEL::INFO, "PORT59 %-11s | portSchema: %4lu cycles | PortCodec: %4lu cycles", description, runtime_cycles,
+        codec_cycles);
+}
+
+/**
+ * @brief Logs the payload length of every port in PORT_REGISTRY, in the FIXED and BIT_PACKED payload formats.
+ */
+void logPayloadLengths(void) {
+    for (size_t p = 0; p < sizeof(PORT_REGISTRY) / sizeof(PORT_REGISTRY[0]); p++) {
+        portSchema fixed_port = PORT_REGISTRY[p];
+        portSchema bit_packed_port = { fixed_port.port_number, fixed_port.sensor_mask, PAYLOAD_FORMAT::BIT_PACKED };
+        log(LOG_LEVEL::INFO, "Port: %2d | fixed: %2d bytes | bit packed: %2d bytes | saved: %d bytes", fixed_port.port_number,
+            fixed_port.payloadLength(), bit_packed_port.payloadLength(),
+            fixed_port.payloadLength() - bit_packed_port.payloadLength());
+    }
+}
+
+/**
+ * @brief Setup code runs once on reset/startup.
+ */
+void setup() {
+    // initialise the logging module - function does nothing if APP_LOG_LEVEL in Logging.h = NONE
+    initLogging();
+    log(LOG_LEVEL::INFO,
+        "\n========================================"
+        "\nWelcome to Port Schema Benchmark Example"
+        "\n========================================");
+
+    initCycleCounter();
+
+    log(LOG_LEVEL::INFO, "Average cycles per value (legacy double -> fixed-point):");
+    for (size_t s = 0; s < SCHEMA_BENCHMARK_LENGTH; s++) {
+        runSchemaBenchmark(&schema_benchmarks[s]);
+    }
+
+    // fill with fake data, making sure to set the validity flag to true
+    sensorData valid_data = { 3712, true, -12.34, true, 56.7, true, 101325, true, 123456, true, -33.9173, 151.2313, true, 12.34, true, 2048 };
+    sensorData invalid_data = {};
+    log(LOG_LEVEL::INFO, "Average cycles per payload (runtime portSchema -> compile time PortCodec):");
+    runPortBenchmark(&valid_data, "all valid");
+    runPortBenchmark(&invalid_data, "all invalid");
+
+    log(LOG_LEVEL::INFO, "Payload length per port (fixed -> bit packed):");
+    logPayloadLengths();
+}
+
+/**
+ * @brief Loop code runs repeated after setup().
+ */
+void loop() {
+    // nothing to do, the benchmark runs once in setup()
+    delay(UINT32_MAX - 1);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file main.cpp
+ * @author Kalina Knight
+ * @brief An example of delta/keyframe encoding consecutive payloads with DeltaPortEncoder.
+ * Slowly changing fake sensor data is encoded for PORT9 every frame, decoded again with DeltaPortDecoder (as the
+ * host-side decoder would) and the average payload length is compared to the FIXED payload format.
+ * This example does not use LoRa at all, it only prints the results.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+
+#include "DeltaPortEncoding.h" /**< Go here to change the keyframe interval. */
+#include "Logging.h"           /**< Go here to change the logging level for the entire application. */
+#include "PortSchema.h"        /**< Go here to see existing and define new sensor/port schemas. */
+
+#define EXAMPLE_FRAMES 64 // Number of frames to encode
+
+// PAYLOAD ENCODING
+#define PAYLOAD_BUFFER_SIZE 64
+
+static portSchema payload_port = PORT9;
+DeltaPortEncoder delta_encoder(payload_port);
+DeltaPortDecoder delta_decoder(payload_port);
+
+uint8_t payload_buffer[PAYLOAD_BUFFER_SIZE] = {};
+
+// fill with fake data, making sure to set the validity flag to true
+sensorData sensor_data = { 3900, true, 21.3, true, 55, true, 101325, true, 120000, true, 0, 0, false, 0, false, 0 };
+
+/**
+ * @brief Setup code runs once on reset/startup.
+ */
+void setup() {
+    // initialise the logging module - function does nothing if APP_LOG_LEVEL in Logging.h = NONE
+    initLogging();
+    log(LOG_LEVEL::INFO,
+        "\n=================================="
+        "\nWelcome to Delta Encoding Example"
+        "\n==================================");
+
+    uint32_t total_length = 0;
+    for (int frame = 0; frame < EXAMPLE_FRAMES; frame++) {
+        // small random changes, like consecutive readings 30 s apart
+        sensorData reading = sensor_data;
+        sensor_data.battery_mv.value -= (random(4) == 0) ? 1 : 0;
+        sensor_data.temperature.value += random(-3, 4) / 100.0;
+        sensor_data.humidity.value += random(-3, 4) / 10.0;
+        sensor_data.pressure.value += random(-4, 5);
+        sensor_data.gas_resist.value += random(-800, 801);
+
+        uint8_t len = delta_encoder.encodeSensorDataToPayload(&reading, payload_buffer);
+        total_length += len;
+
+        sensorData decoded = {};
+        bool decoded_ok = delta_decoder.decodePayloadToSensorData(payload_buffer, len, &decoded);
+        log(LOG_LEVEL::INFO, "Frame %2d | %s | %2d bytes | decoded: %s | t: %.2f C | p: %lu Pa", frame,
+            (payload_buffer[0] & DELTA_FRAME_KEYFRAME_FLAG) ? "keyframe" : "delta   ", len, decoded_ok ? "yes" : "no ",
+            decoded.temperature.value, decoded.pressure.value);
+    }
+
+    log(LOG_LEVEL::INFO, "Port %d average payload: %.2f bytes delta encoded, %d bytes fixed.", payload_port.port_number,
+        (float)total_length / EXAMPLE_FRAMES, payload_port.payloadLength());
+}
+
+/**
+ * @brief Loop code runs repeated after setup().
+ */
+void loop() {
+    // nothing to do, the example runs once in setup()
+    delay(UINT32_MAX - 1);
+}
@@ -0,0 +1,135 @@
+#include "ColumnarBatchDecoder.h"
+
+/**
+ * @brief Sets the validity bit of a record.
+ * @param column Column of the sensor field.
+ * @param record Index of the record.
+ */
+static inline void setValid(sensorColumn *column, size_t record) {
+    column->validity[record / 64] |= (1ULL << (record % 64));
+}
+
+/**
+ * @brief Decodes each value of a sensor field from the buffer into its column.
+ * @param f Index of the sensor field in SENSOR_FIELDS.
+ * @param column Column of the sensor field.
+ * @param record Index of the record.
+ * @param buffer Buffer that data will be decoded from.
+ * @param buf_pos Start decoding from this byte.
+ * @return New total length of data decoded from buffer - includes buf_pos.
+ */
+static uint8_t decodeFieldToColumn(uint8_t f, sensorColumn *column, size_t record, uint8_t *buffer, uint8_t buf_pos) {
+    const sensorField *field = &SENSOR_FIELDS[f];
+    bool valid = false;
+
+    for (uint8_t v = 0; v < field->schema->n_values; v++) {
+        if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+            buf_pos = field->schema->decodeData(&column->float_values[v][record], &valid, buffer, buf_pos);
+        } else {
+            buf_pos = field->schema->decodeData(&column->uint_values[v][record], &valid, buffer, buf_pos);
+        }
+    }
+    if (valid) {
+        setValid(column, record);
+    }
+    return buf_pos;
+}
+
+/**
+ * @brief Bit decodes each value of a sensor field from the buffer into its column, for the BIT_PACKED payload format.
+ * @param f Index of the sensor field in SENSOR_FIELDS.
+ * @param column Column of the sensor field.
+ * @param record Index of the record.
+ * @param buffer Buffer that data will be decoded from.
+ * @param bit_pos Start decoding from this bit.
+ * @return New total length (in bits) of data decoded from buffer - includes bit_pos.
+ */
+static uint16_t decodeFieldBitsToColumn(uint8_t f, sensorColumn *column, size_t record, uint8_t *buffer,
+                                        uint16_t bit_pos) {
+    const sensorField *field = &SENSOR_FIELDS[f];
+    bool valid = false;
+
+    for (uint8_t v = 0; v < field->schema->n_values; v++) {
+        if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+            bit_pos = field->schema->decodeBits(&column->float_values[v][record], &valid, buffer, bit_pos);
+        } else {
+            bit_pos = field->schema->decodeBits(&column->uint_values[v][record], &valid, buffer, bit_pos);
+        }
+    }
+    if (valid) {
+        setValid(column, record);
+    }
+    return bit_pos;
+}
+
+/**
+ * @brief Decodes one record into the columns, following the same steps (and length checks) as
+ * portSchema::decodePayloadToSensorData() for each payload format.
+ * @param port Port of the record.
+ * @param record Index of the record.
+ * @param buffer Payload buffer to be decoded.
+ * @param len Length of payload buffer.
+ * @param columns Columns the record is decoded into.
+ */
+static void decodeRecord(portSchema port, size_t record, uint8_t *buffer, uint8_t len, sensorColumns *columns) {
+    if (port.payload_format == PAYLOAD_FORMAT::BIT_PACKED) {
+        uint16_t bit_pos = 0;
+        for (uint16_t fields = port.sensor_mask; fields != 0; fields &= (fields - 1)) {
+            uint8_t f = __builtin_ctz(fields);
+            if ((bit_pos + SENSOR_FIELDS[f].schema->n_bits * SENSOR_FIELDS[f].schema->n_values) > (len * 8)) {
+                break;
+            }
+            bit_pos = decodeFieldBitsToColumn(f, &columns->fields[f], record, buffer, bit_pos);
+        }
+        return;
+    }
+
+    uint8_t buf_pos = 0;
+    const uint8_t *bitmap = buffer;
+    if (port.payload_format == PAYLOAD_FORMAT::PRESENCE_BITMAP) {
+        buf_pos = presenceBitmapLength(port.sensor_mask);
+        if (buf_pos > len) {
+            return; // too short for the bitmap
+        }
+    }
+
+    uint8_t bit = 0;
+    for (uint16_t fields = port.sensor_mask; (fields != 0) && (buf_pos < len); fields &= (fields - 1), bit++) {
+        if ((port.payload_format == PAYLOAD_FORMAT::PRESENCE_BITMAP) && !(bitmap[bit / 8] & (0x80 >> (bit % 8)))) {
+            continue;
+        }
+        uint8_t f = __builtin_ctz(fields);
+        buf_pos = decodeFieldToColumn(f, &columns->fields[f], record, buffer, buf_pos);
+    }
+}
+
+void resizeColumns(sensorColumns *columns, size_t n_records) {
+    columns->n_records = n_records;
+    columns->port_numbers.assign(n_records, 0);
+    for (uint8_t f = 0; f < (uint8_t)SENSOR_FIELD::COUNT; f++) {
+        sensorColumn *column = &columns->fields[f];
+        bool is_float = (SENSOR_FIELDS[f].value_type == SENSOR_VALUE_TYPE::FLOAT);
+        for (uint8_t v = 0; v < MAX_FIELD_VALUES; v++) {
+            size_t length = (v < SENSOR_FIELDS[f].schema->n_values) ? n_records : 0;
+            column->float_values[v].assign(is_float ? length : 0, 0);
+            column->uint_values[v].assign(is_float ? 0 : length, 0);
+        }
+        column->validity.assign((n_records + 63) / 64, 0);
+    }
+}
+
+size_t decodeBatchToColumns(const uplinkRecord *records, size_t n_records, sensorColumns *columns) {
+    resizeColumns(columns, n_records);
+
+    size_t n_decoded = 0;
+    for (size_t r = 0; r < n_records; r++) {
+        columns->port_numbers[r] = records[r].port_number;
+        portSchema port = getPort(records[r].port_number);
+        if (port == PORTERROR) {
+            continue;
+        }
+        decodeRecord(port, r, records[r].payload, records[r].len, columns);
+        n_decoded++;
+    }
+    return n_decoded;
+}
@@ -0,0 +1,66 @@
+#ifndef COLUMNAR_BATCH_DECODER_H
+#define COLUMNAR_BATCH_DECODER_H
+
+/**
+ * @file ColumnarBatchDecoder.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief Host-side decoder of a whole batch of uplinks (e.g. archived from many devices) into columns.
+ * Each value of each sensor field gets its own array (struct-of-arrays) with a validity bitmap per field, decoded
+ * straight from the payloads with the same sensor/port schemas as the devices.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <vector>
+
+#include "PortSchema.h"
+
+/** @brief An uplink to be decoded, the payload isn't copied so must outlive the decoding. */
+struct uplinkRecord {
+    uint8_t port_number; /**< LoRaWAN port the payload was sent on. */
+    uint8_t len;         /**< Length of payload. */
+    uint8_t *payload;    /**< Payload buffer. */
+};
+
+/** @brief The decoded values of one sensor field, for every record of a batch. */
+struct sensorColumn {
+    std::vector<float> float_values[MAX_FIELD_VALUES];   /**< Values if the field's value type is FLOAT, else empty. */
+    std::vector<uint32_t> uint_values[MAX_FIELD_VALUES]; /**< Values if the field's value type is UINT32, else empty. */
+    std::vector<uint64_t> validity;                      /**< Bit per record, set if its value(s) are valid. */
+
+    /**
+     * @brief Checks if a record has valid data for this field.
+     * Records with an undefined port, or a port that doesn't send the field, are invalid (and their values 0).
+     * @param record Index of the record.
+     * @return True if valid.
+     */
+    inline bool isValid(size_t record) const { return ((validity[record / 64] >> (record % 64)) & 1) != 0; };
+};
+
+/** @brief Decoded batch of uplinks as columns, indexed by record. */
+struct sensorColumns {
+    size_t n_records = 0;
+    std::vector<uint8_t> port_numbers;                  /**< Port number of each record. */
+    sensorColumn fields[(uint8_t)SENSOR_FIELD::COUNT]; /**< Column of each sensor field, indexed by SENSOR_FIELD. */
+};
+
+/**
+ * @brief Sizes every column for the number of records, with all values 0 and invalid.
+ * @param columns Columns to resize.
+ * @param n_records Number of records.
+ */
+void resizeColumns(sensorColumns *columns, size_t n_records);
+
+/**
+ * @brief Decodes a batch of uplinks into columns, the same as portSchema::decodePayloadToSensorData() per record.
+ * @param records Uplinks to be decoded.
+ * @param n_records Number of records.
+ * @param columns Resulting columns, resized to n_records.
+ * @return Number of records decoded, i.e. not an undefined port.
+ */
+size_t decodeBatchToColumns(const uplinkRecord *records, size_t n_records, sensorColumns *columns);
+
+#endif // COLUMNAR_BATCH_DECODER_H
@@ -0,0 +1,28 @@
+#include "DeltaDeviceDecoder.h"
+
+bool DeltaDeviceDecoder::decodePayloadToSensorData(uint64_t dev_eui, uint8_t port_number, uint8_t *buffer, uint8_t len,
+                                                   sensorData *sensor_data) {
+    *sensor_data = sensorData{};
+    portSchema port = getPort(port_number);
+    if (port == PORTERROR) {
+        log(LOG_LEVEL::WARN, "Port %d is not defined.", port_number);
+        return false;
+    }
+
+    std::pair<uint64_t, uint8_t> key(dev_eui, port_number);
+    auto decoder = decoders.find(key);
+    if (decoder == decoders.end()) {
+        decoder = decoders.insert(std::make_pair(key, DeltaPortDecoder(port))).first;
+    }
+    return decoder->second.decodePayloadToSensorData(buffer, len, sensor_data);
+}
+
+void DeltaDeviceDecoder::forgetDevice(uint64_t dev_eui) {
+    for (auto decoder = decoders.begin(); decoder != decoders.end();) {
+        if (decoder->first.first == dev_eui) {
+            decoder = decoders.erase(decoder);
+        } else {
+            ++decoder;
+        }
+    }
+}
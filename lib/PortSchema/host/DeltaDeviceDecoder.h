@@ -0,0 +1,49 @@
+#ifndef DELTA_DEVICE_DECODER_H
+#define DELTA_DEVICE_DECODER_H
+
+/**
+ * @file DeltaDeviceDecoder.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief Host-side decoder of delta encoded payloads (see DeltaPortEncoding.h) from any number of devices.
+ * Keeps a DeltaPortDecoder, and hence the state of the last frame, per device and port.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <map>
+#include <utility>
+
+#include "DeltaPortEncoding.h"
+
+/**
+ * @brief DeltaDeviceDecoder decodes the delta encoded payloads of many devices, keeping the state of each.
+ */
+class DeltaDeviceDecoder {
+  public:
+    /**
+     * @brief Decodes the given keyframe or delta frame of a device into the sensor data.
+     * The device's decoder for the port is created on its first payload, which must be a keyframe to be decoded.
+     * @param dev_eui Device EUI the payload is from.
+     * @param port_number LoRaWAN port the payload was sent on, must be defined in PortSchema.h.
+     * @param buffer Payload buffer to be decoded.
+     * @param len Length of payload buffer.
+     * @param sensor_data Resulting decoded sensor data.
+     * @return True if decoded. False if not, i.e. an unknown port or see DeltaPortDecoder::decodePayloadToSensorData.
+     */
+    bool decodePayloadToSensorData(uint64_t dev_eui, uint8_t port_number, uint8_t *buffer, uint8_t len,
+                                   sensorData *sensor_data);
+
+    /**
+     * @brief Drops the state of a device, e.g. once it has rejoined the network.
+     * @param dev_eui Device EUI.
+     */
+    void forgetDevice(uint64_t dev_eui);
+
+  private:
+    std::map<std::pair<uint64_t, uint8_t>, DeltaPortDecoder> decoders; /**< Keyed by device EUI & port number. */
+};
+
+#endif // DELTA_DEVICE_DECODER_H
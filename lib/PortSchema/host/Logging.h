@@ -0,0 +1,47 @@
+#pragma once
+/**
+ * @file Logging.h
+ * @author Kalina Knight
+ * @brief Host (PC) stand-in for the Logging library, so the PortSchema library can be compiled for the host-side
+ * decoders. Found instead of lib/Logging/src/Logging.h by putting this folder first on the include path.
+ * Logs are printed to stderr.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+enum class LOG_LEVEL {
+    NONE = 0,  /**< Disable logging. No messages are logged. */
+    ERROR = 1, /**< Only ERROR level messages are logged. */
+    WARN = 2,  /**< ERROR & WARN level messages are logged. */
+    INFO = 3,  /**< ERROR, WARN & INFO level messages are logged. */
+    DEBUG = 4  /**< ERROR, WARN, INFO & DEBUG level messages are logged. */
+};
+
+// Set the logging level for the host-side decoders here:
+#define APP_LOG_LEVEL LOG_LEVEL::WARN
+
+/**
+ * @brief Formats and logs the message to stderr if it is of level >= APP_LOG_LEVEL.
+ * @param level The level of the log message. See enum LOG_LEVEL.
+ * @param format Print format for the message.
+ * @param ... (Optional) Any additional arguments for the format.
+ */
+inline void log(LOG_LEVEL level, const char *format, ...) {
+    if ((level == LOG_LEVEL::NONE) || (level > APP_LOG_LEVEL)) {
+        return;
+    }
+    static const char *level_names[] = { "NONE", "ERROR", "WARN", "INFO", "DEBUG" };
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s: ", level_names[(int)level]);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
@@ -0,0 +1,244 @@
+#include "SimdFieldExtract.h"
+
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+/** @brief Where a value sits in every frame and how to decode it. */
+struct valueLayout {
+    uint8_t offset;       /**< Byte of the frame the value starts at. */
+    uint8_t value_bytes;  /**< Bytes of the value. */
+    bool is_signed;
+    uint32_t scale_num;
+    uint32_t scale_den;
+    bool is_float;        /**< Decode to float (else uint32_t). */
+    uint32_t invalid;     /**< Value sent for invalid data. */
+};
+
+/**
+ * @brief Checks if the SIMD kernels can decode a value.
+ * They convert to float from int32, and have no integer division for the scale factor.
+ * @param layout Layout of the value.
+ * @return True if they can.
+ */
+static bool simdSupported(const valueLayout *layout) {
+    if (layout->is_float) {
+        return layout->is_signed || (layout->value_bytes < MAX_VALUE_BYTES);
+    }
+    return layout->scale_num == layout->scale_den;
+}
+
+/**
+ * @brief Sets the validity bits of a run of frames.
+ * @param validity Validity bitmap, or nullptr to skip.
+ * @param i Index of the first frame, a multiple of the run length.
+ * @param mask Bit per frame of the run, set if valid.
+ */
+static inline void setValidBits(uint64_t *validity, size_t i, uint32_t mask) {
+    if (validity != nullptr) {
+        validity[i / 64] |= (uint64_t)mask << (i % 64);
+    }
+}
+
+/**
+ * @brief Decodes a value from frames i to n_frames, one at a time.
+ * The same steps as sensorPortSchema::decodeData(): MSB byte load, sentinel check, sign extend & scale.
+ */
+static void extractScalar(const uint8_t *frames, size_t stride, size_t i, size_t n_frames, const valueLayout *layout,
+                          void *values, uint64_t *validity) {
+    for (; i < n_frames; i++) {
+        const uint8_t *value = &frames[i * stride + layout->offset];
+        uint32_t bits = 0;
+        for (uint8_t b = 0; b < layout->value_bytes; b++) {
+            bits = (bits << 8) | value[b];
+        }
+        if (bits == layout->invalid) {
+            continue; // left 0 & invalid
+        }
+        setValidBits(validity, i, 1);
+
+        if (layout->is_float) {
+            float *sensor_data = &((float *)values)[i];
+            if (layout->is_signed) {
+                scaleFromFixedPoint(signExtend(bits, layout->value_bytes), sensor_data, layout->scale_num,
+                                    layout->scale_den);
+            } else {
+                scaleFromFixedPoint(bits, sensor_data, layout->scale_num, layout->scale_den);
+            }
+        } else {
+            uint32_t *sensor_data = &((uint32_t *)values)[i];
+            if (layout->is_signed) {
+                scaleFromFixedPoint(signExtend(bits, layout->value_bytes), sensor_data, layout->scale_num,
+                                    layout->scale_den);
+            } else {
+                scaleFromFixedPoint(bits, sensor_data, layout->scale_num, layout->scale_den);
+            }
+        }
+    }
+}
+
+#if defined(__SSSE3__)
+/**
+ * @brief Decodes a value from 4 frames at a time, from frame 0 until fewer than 4 are left.
+ * @return Index of the first frame not decoded.
+ */
+static size_t extractSse(const uint8_t *frames, size_t stride, size_t n_frames, const valueLayout *layout,
+                         void *values, uint64_t *validity) {
+    const __m128i byte_swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m128i shift = _mm_cvtsi32_si128(8 * (MAX_VALUE_BYTES - layout->value_bytes));
+    const __m128i invalid = _mm_set1_epi32((int)layout->invalid);
+    const __m128 scale_num = _mm_set1_ps((float)layout->scale_num);
+    const __m128 scale_den = _mm_set1_ps((float)layout->scale_den);
+
+    size_t i = 0;
+    for (; (i + 4) <= n_frames; i += 4) {
+        const uint8_t *value = &frames[i * stride + layout->offset];
+        int32_t words[4];
+        for (int lane = 0; lane < 4; lane++) {
+            memcpy(&words[lane], &value[lane * stride], sizeof(words[lane]));
+        }
+        // MSB first bytes -> the value in the top bytes of each lane, then shifted down to the bottom
+        __m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)words), byte_swap);
+        __m128i bits = _mm_srl_epi32(bytes, shift);
+        __m128i valid = _mm_xor_si128(_mm_cmpeq_epi32(bits, invalid), _mm_set1_epi32(-1));
+        __m128i fixed_point = layout->is_signed ? _mm_sra_epi32(bytes, shift) : bits;
+
+        if (layout->is_float) {
+            __m128 data = _mm_cvtepi32_ps(fixed_point);
+            if (layout->scale_den != 1) {
+                data = _mm_mul_ps(data, scale_den);
+            }
+            data = _mm_div_ps(data, scale_num);
+            _mm_storeu_ps(&((float *)values)[i], _mm_and_ps(data, _mm_castsi128_ps(valid)));
+        } else {
+            _mm_storeu_si128((__m128i *)&((uint32_t *)values)[i], _mm_and_si128(fixed_point, valid));
+        }
+        setValidBits(validity, i, (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(valid)));
+    }
+    return i;
+}
+#endif
+
+#if defined(__AVX2__)
+/**
+ * @brief Decodes a value from 8 frames at a time, from frame 0 until fewer than 8 are left.
+ * @return Index of the first frame not decoded.
+ */
+static size_t extractAvx2(const uint8_t *frames, size_t stride, size_t n_frames, const valueLayout *layout,
+                          void *values, uint64_t *validity) {
+    const __m256i byte_swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,  //
+                                               3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i lane_offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                    _mm256_set1_epi32((int)stride));
+    const __m128i shift = _mm_cvtsi32_si128(8 * (MAX_VALUE_BYTES - layout->value_bytes));
+    const __m256i invalid = _mm256_set1_epi32((int)layout->invalid);
+    const __m256 scale_num = _mm256_set1_ps((float)layout->scale_num);
+    const __m256 scale_den = _mm256_set1_ps((float)layout->scale_den);
+
+    size_t i = 0;
+    for (; (i + 8) <= n_frames; i += 8) {
+        const int *value = (const int *)&frames[i * stride + layout->offset];
+        // MSB first bytes -> the value in the top bytes of each lane, then shifted down to the bottom
+        __m256i bytes = _mm256_shuffle_epi8(_mm256_i32gather_epi32(value, lane_offsets, 1), byte_swap);
+        __m256i bits = _mm256_srl_epi32(bytes, shift);
+        __m256i valid = _mm256_xor_si256(_mm256_cmpeq_epi32(bits, invalid), _mm256_set1_epi32(-1));
+        __m256i fixed_point = layout->is_signed ? _mm256_sra_epi32(bytes, shift) : bits;
+
+        if (layout->is_float) {
+            __m256 data = _mm256_cvtepi32_ps(fixed_point);
+            if (layout->scale_den != 1) {
+                data = _mm256_mul_ps(data, scale_den);
+            }
+            data = _mm256_div_ps(data, scale_num);
+            _mm256_storeu_ps(&((float *)values)[i], _mm256_and_ps(data, _mm256_castsi256_ps(valid)));
+        } else {
+            _mm256_storeu_si256((__m256i *)&((uint32_t *)values)[i], _mm256_and_si256(fixed_point, valid));
+        }
+        setValidBits(validity, i, (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(valid)));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @brief Decodes a value from every frame with the given kernel, the scalar kernel finishing any frames left over.
+ * @param validity Validity bitmap to set, or nullptr to skip.
+ */
+static void extractValue(EXTRACT_KERNEL kernel, const uint8_t *frames, size_t stride, size_t n_frames,
+                         const valueLayout *layout, void *values, uint64_t *validity) {
+    size_t i = 0;
+    if (simdSupported(layout)) {
+        switch (kernel) {
+#if defined(__AVX2__)
+            case EXTRACT_KERNEL::AVX2:
+                i = extractAvx2(frames, stride, n_frames, layout, values, validity);
+                break;
+#endif
+#if defined(__SSSE3__)
+            case EXTRACT_KERNEL::SSE:
+                i = extractSse(frames, stride, n_frames, layout, values, validity);
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+    extractScalar(frames, stride, i, n_frames, layout, values, validity);
+}
+
+EXTRACT_KERNEL bestExtractKernel(void) {
+#if defined(__AVX2__)
+    return EXTRACT_KERNEL::AVX2;
+#elif defined(__SSSE3__)
+    return EXTRACT_KERNEL::SSE;
+#else
+    return EXTRACT_KERNEL::SCALAR;
+#endif
+}
+
+const char *extractKernelName(EXTRACT_KERNEL kernel) {
+    switch (kernel) {
+        case EXTRACT_KERNEL::AVX2:
+            return "AVX2";
+        case EXTRACT_KERNEL::SSE:
+            return "SSE";
+        default:
+            return "scalar";
+    }
+}
+
+bool decodeFramesToColumns(portSchema port, const uint8_t *frames, size_t stride, size_t n_frames,
+                           sensorColumns *columns, EXTRACT_KERNEL kernel) {
+    if ((port.payload_format != PAYLOAD_FORMAT::FIXED) || (stride < port.payloadLength())) {
+        log(LOG_LEVEL::WARN, "Port %d: can only decode FIXED frames at least %d bytes apart.", port.port_number,
+            port.payloadLength());
+        return false;
+    }
+
+    resizeColumns(columns, n_frames);
+    columns->port_numbers.assign(n_frames, port.port_number);
+
+    uint8_t offset = 0;
+    for (uint16_t fields = port.sensor_mask; fields != 0; fields &= (fields - 1)) {
+        uint8_t f = __builtin_ctz(fields);
+        const sensorField *field = &SENSOR_FIELDS[f];
+        const sensorPortSchema *schema = field->schema;
+        sensorColumn *column = &columns->fields[f];
+        bool is_float = (field->value_type == SENSOR_VALUE_TYPE::FLOAT);
+        uint8_t value_bytes = schema->n_bytes / schema->n_values;
+
+        for (uint8_t v = 0; v < schema->n_values; v++) {
+            valueLayout layout = { offset,           value_bytes, schema->is_signed,
+                                   schema->scale_num, schema->scale_den, is_float,
+                                   invalidFieldValue(schema->is_signed, value_bytes) };
+            void *values = is_float ? (void *)column->float_values[v].data() : (void *)column->uint_values[v].data();
+            // like decodeData(), the field is valid if its last value is
+            uint64_t *validity = (v == (schema->n_values - 1)) ? column->validity.data() : nullptr;
+            extractValue(kernel, frames, stride, n_frames, &layout, values, validity);
+            offset += value_bytes;
+        }
+    }
+    return true;
+}
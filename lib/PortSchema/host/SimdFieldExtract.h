@@ -0,0 +1,58 @@
+#ifndef SIMD_FIELD_EXTRACT_H
+#define SIMD_FIELD_EXTRACT_H
+
+/**
+ * @file SimdFieldExtract.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief Host-side decoding of many FIXED payload format frames of one port at once, a field at a time.
+ * Frames of a port share a fixed layout, so each value sits at the same byte of every frame. The SSE/AVX2 kernels
+ * gather that value from 4/8 frames at once then byte-swap, sign-extend, sentinel-check (into a validity bitmap) and
+ * scale it; the scalar kernel gives identical output on any CPU. The SIMD kernels are compiled in with -mssse3 /
+ * -mavx2 (or -march=native).
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include "ColumnarBatchDecoder.h"
+
+#define EXTRACT_PADDING (MAX_VALUE_BYTES - 1) /**< Bytes readable past the last frame: every value is read as 4 bytes. */
+
+/** @brief Field extraction kernel. */
+enum class EXTRACT_KERNEL : uint8_t {
+    SCALAR = 0, /**< One value at a time, any CPU. */
+    SSE,        /**< 4 values at a time, if compiled with SSSE3. */
+    AVX2,       /**< 8 values at a time, if compiled with AVX2. */
+};
+
+/**
+ * @brief Get the fastest kernel compiled in.
+ * @return The kernel.
+ */
+EXTRACT_KERNEL bestExtractKernel(void);
+
+/**
+ * @brief Get the name of a kernel, for logging.
+ * @param kernel The kernel.
+ * @return The name.
+ */
+const char *extractKernelName(EXTRACT_KERNEL kernel);
+
+/**
+ * @brief Decodes same port frames laid out at a fixed stride into columns, a field at a time.
+ * Gives the same columns as decodeBatchToColumns() of the frames. Values the SIMD kernels can't do in one step (an
+ * integer scale factor of UINT32 data, or 4 byte unsigned FLOAT data) are left to the scalar kernel.
+ * @param port Port of every frame, must be in the FIXED payload format.
+ * @param frames Frames to be decoded, frame i starts at frames[i * stride], with EXTRACT_PADDING bytes after the last.
+ * @param stride Bytes from the start of one frame to the next, at least port.payloadLength().
+ * @param n_frames Number of frames.
+ * @param columns Resulting columns, resized to n_frames.
+ * @param kernel Kernel to use, it must be compiled in (see bestExtractKernel()) or SCALAR is used.
+ * @return True if decoded, false if the port isn't FIXED or the stride is too short.
+ */
+bool decodeFramesToColumns(portSchema port, const uint8_t *frames, size_t stride, size_t n_frames,
+                           sensorColumns *columns, EXTRACT_KERNEL kernel);
+
+#endif // SIMD_FIELD_EXTRACT_H
@@ -0,0 +1,122 @@
+/**
+ * @file columnar_decoder_benchmark.cpp
+ * @author Kalina Knight
+ * @brief Host-side benchmark of decodeBatchToColumns(), see the PortSchema README for how to build it.
+ * Builds a synthetic dataset of a million uplinks spread over every port in PORT_REGISTRY (with some invalid sensor
+ * data), then reports the frames per second of decoding it per frame with portSchema::decodePayloadToSensorData() and
+ * as a batch into columns. The two are also checked to decode the same values.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <chrono>
+#include <random>
+
+#include "ColumnarBatchDecoder.h"
+
+#define BENCHMARK_RECORDS 1000000
+#define BENCHMARK_RUNS 5 // the best of these runs is reported
+
+/**
+ * @brief Fills the sensor data with random readings, each sensor invalid 1 in 20 times.
+ * @param rng Random number generator.
+ * @param sensor_data Resulting sensor data.
+ */
+static void randomSensorData(std::mt19937 *rng, sensorData *sensor_data) {
+    std::uniform_real_distribution<float> unit(0, 1);
+    auto valid = [&]() { return unit(*rng) >= 0.05f; };
+
+    sensor_data->battery_mv = { 3300 + 900 * unit(*rng), valid() };
+    sensor_data->temperature = { -10 + 50 * unit(*rng), valid() };
+    sensor_data->humidity = { 100 * unit(*rng), valid() };
+    sensor_data->pressure = { (uint32_t)(95000 + 10000 * unit(*rng)), valid() };
+    sensor_data->gas_resist = { (uint32_t)(500000 * unit(*rng)), valid() };
+    sensor_data->location = { -34 + unit(*rng), 151 + unit(*rng), valid() };
+    sensor_data->current_A = { 20 * unit(*rng), valid(), 3300 * unit(*rng) };
+    sensor_data->ac_current = { 20 * unit(*rng), 30 * unit(*rng), valid() };
+    sensor_data->harmonics = { 20 * unit(*rng), 2 * unit(*rng), unit(*rng), unit(*rng), valid() };
+    sensor_data->thd = { 20 * unit(*rng), valid() };
+}
+
+/**
+ * @brief Checks the columns match the per frame decoding of a record.
+ * @param columns Decoded columns.
+ * @param r Index of the record.
+ * @param sensor_data Per frame decoded sensor data of the record.
+ * @return True if they match.
+ */
+static bool recordMatches(const sensorColumns *columns, size_t r, const sensorData *sensor_data) {
+    const uint8_t *data = (const uint8_t *)sensor_data;
+    for (uint8_t f = 0; f < (uint8_t)SENSOR_FIELD::COUNT; f++) {
+        const sensorField *field = &SENSOR_FIELDS[f];
+        const sensorColumn *column = &columns->fields[f];
+        bool valid = *(const bool *)(data + field->valid_offset);
+        if (column->isValid(r) != valid) {
+            return false;
+        }
+        for (uint8_t v = 0; valid && (v < field->schema->n_values); v++) {
+            const uint8_t *value = data + field->value_offsets[v];
+            if ((field->value_type == SENSOR_VALUE_TYPE::FLOAT) ? (column->float_values[v][r] != *(const float *)value)
+                                                                : (column->uint_values[v][r] != *(const uint32_t *)value)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(void) {
+    const size_t n_ports = sizeof(PORT_REGISTRY) / sizeof(PORT_REGISTRY[0]);
+    std::mt19937 rng(2021);
+
+    // build the dataset, with the payloads back to back in one buffer
+    std::vector<uint8_t> payloads(BENCHMARK_RECORDS * PORT59.payloadLength());
+    std::vector<uplinkRecord> records(BENCHMARK_RECORDS);
+    size_t buf_pos = 0;
+    for (size_t r = 0; r < BENCHMARK_RECORDS; r++) {
+        portSchema port = PORT_REGISTRY[rng() % n_ports];
+        sensorData sensor_data = {};
+        randomSensorData(&rng, &sensor_data);
+        uint8_t len = port.encodeSensorDataToPayload(&sensor_data, &payloads[buf_pos]);
+        records[r] = { port.port_number, len, &payloads[buf_pos] };
+        buf_pos += len;
+    }
+    printf("%d records, %zu payload bytes\n", BENCHMARK_RECORDS, buf_pos);
+
+    // per frame
+    double best_per_frame = 0;
+    std::vector<sensorData> decoded(BENCHMARK_RECORDS);
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < BENCHMARK_RECORDS; r++) {
+            decoded[r] = getPort(records[r].port_number).decodePayloadToSensorData(records[r].payload, records[r].len);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double fps = BENCHMARK_RECORDS / elapsed.count();
+        best_per_frame = (fps > best_per_frame) ? fps : best_per_frame;
+    }
+
+    // batch into columns
+    double best_columnar = 0;
+    sensorColumns columns;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        decodeBatchToColumns(records.data(), records.size(), &columns);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double fps = BENCHMARK_RECORDS / elapsed.count();
+        best_columnar = (fps > best_columnar) ? fps : best_columnar;
+    }
+
+    size_t mismatches = 0;
+    for (size_t r = 0; r < BENCHMARK_RECORDS; r++) {
+        mismatches += recordMatches(&columns, r, &decoded[r]) ? 0 : 1;
+    }
+
+    printf("per frame (sensorData): %10.0f frames/s\n", best_per_frame);
+    printf("batch (columns):        %10.0f frames/s (%.2fx)\n", best_columnar, best_columnar / best_per_frame);
+    printf("mismatches: %zu\n", mismatches);
+    return (mismatches == 0) ? 0 : 1;
+}
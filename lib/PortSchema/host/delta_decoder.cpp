@@ -0,0 +1,122 @@
+/**
+ * @file delta_decoder.cpp
+ * @author Kalina Knight
+ * @brief Host-side command line decoder of delta encoded payloads, see the PortSchema README for how to build it.
+ * Reads one uplink per line from stdin: "<device EUI (hex)> <port number> <payload (hex)>",
+ * e.g. "70B3D57ED0041234 7 8A0E7402F201018BCD"
+ * and prints the decoded sensor data of each, as JSON, to stdout. Frames that can't be decoded (lost keyframe or bad
+ * line) print "null".
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "DeltaDeviceDecoder.h"
+
+#define MAX_LINE_LENGTH 256
+
+/**
+ * @brief Converts a hex string into bytes.
+ * @param hex Hex string, without spaces.
+ * @param buffer Resulting bytes.
+ * @param buffer_size Size of buffer.
+ * @return Number of bytes, or -1 if the string isn't valid hex or doesn't fit.
+ */
+static int hexToBytes(const char *hex, uint8_t *buffer, size_t buffer_size) {
+    size_t len = strlen(hex);
+    if (((len % 2) != 0) || ((len / 2) > buffer_size)) {
+        return -1;
+    }
+    for (size_t i = 0; i < len / 2; i++) {
+        unsigned int byte = 0;
+        if (sscanf(&hex[2 * i], "%2x", &byte) != 1) {
+            return -1;
+        }
+        buffer[i] = (uint8_t)byte;
+    }
+    return (int)(len / 2);
+}
+
+/**
+ * @brief Prints the sensor data of the port as JSON.
+ * @param port Port of the payload, only its sensor data is printed.
+ * @param sensor_data Decoded sensor data.
+ */
+static void printSensorData(portSchema port, const sensorData *sensor_data) {
+    const char *separator = "";
+    printf("{");
+    if (port.sends(SENSOR_FIELD::BATTERY_VOLTAGE) && sensor_data->battery_mv.is_valid) {
+        printf("%s\"battery_mv\": %.0f", separator, sensor_data->battery_mv.value);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::TEMPERATURE) && sensor_data->temperature.is_valid) {
+        printf("%s\"temperature\": %.2f", separator, sensor_data->temperature.value);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::RELATIVE_HUMIDITY) && sensor_data->humidity.is_valid) {
+        printf("%s\"humidity\": %.1f", separator, sensor_data->humidity.value);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::AIR_PRESSURE) && sensor_data->pressure.is_valid) {
+        printf("%s\"pressure\": %" PRIu32, separator, sensor_data->pressure.value);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::GAS_RESISTANCE) && sensor_data->gas_resist.is_valid) {
+        printf("%s\"gas_resistance\": %" PRIu32, separator, sensor_data->gas_resist.value);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::LOCATION) && sensor_data->location.is_valid) {
+        printf("%s\"latitude\": %.4f, \"longitude\": %.4f", separator, sensor_data->location.latitude,
+               sensor_data->location.longitude);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::CURRENT_SENSOR) && sensor_data->current_A.is_valid) {
+        printf("%s\"current_A\": %.2f, \"current_ADC_mV\": %.2f", separator, sensor_data->current_A.value,
+               sensor_data->current_A.ADCval);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::AC_CURRENT) && sensor_data->ac_current.is_valid) {
+        printf("%s\"ac_current_rms_A\": %.2f, \"ac_current_peak_A\": %.2f", separator, sensor_data->ac_current.rms,
+               sensor_data->ac_current.peak);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::HARMONICS) && sensor_data->harmonics.is_valid) {
+        printf("%s\"harmonics_A\": [%.2f, %.2f, %.2f, %.2f]", separator, sensor_data->harmonics.fundamental,
+               sensor_data->harmonics.h3, sensor_data->harmonics.h5, sensor_data->harmonics.h7);
+        separator = ", ";
+    }
+    if (port.sends(SENSOR_FIELD::THD) && sensor_data->thd.is_valid) {
+        printf("%s\"thd_percent\": %.2f", separator, sensor_data->thd.value);
+    }
+    printf("}\n");
+}
+
+int main(void) {
+    DeltaDeviceDecoder decoder;
+    char line[MAX_LINE_LENGTH];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        char hex[MAX_LINE_LENGTH] = {};
+        uint64_t dev_eui = 0;
+        unsigned int port_number = 0;
+        uint8_t payload[UINT8_MAX] = {};
+        sensorData sensor_data = {};
+
+        if ((sscanf(line, "%" SCNx64 " %u %255s", &dev_eui, &port_number, hex) != 3) || (port_number > UINT8_MAX)) {
+            printf("null\n");
+            continue;
+        }
+        int len = hexToBytes(hex, payload, sizeof(payload));
+        if ((len < 0) || !decoder.decodePayloadToSensorData(dev_eui, port_number, payload, len, &sensor_data)) {
+            printf("null\n");
+            continue;
+        }
+        printSensorData(getPort(port_number), &sensor_data);
+    }
+    return 0;
+}
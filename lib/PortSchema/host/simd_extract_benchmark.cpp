@@ -0,0 +1,123 @@
+/**
+ * @file simd_extract_benchmark.cpp
+ * @author Kalina Knight
+ * @brief Host-side benchmark of decodeFramesToColumns(), see the PortSchema README for how to build it.
+ * Builds a million synthetic PORT59 frames (with some invalid sensor data) back to back, then reports the frames per
+ * second of decoding them with decodeBatchToColumns() and with decodeFramesToColumns() using each kernel compiled in.
+ * Every kernel is also checked to give exactly the same columns as decodeBatchToColumns().
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <chrono>
+#include <random>
+
+#include "SimdFieldExtract.h"
+
+#define BENCHMARK_FRAMES 1000000
+#define BENCHMARK_RUNS 5 // the best of these runs is reported
+
+static constexpr portSchema BENCHMARK_PORT = PORT59;
+
+/**
+ * @brief Checks two sets of columns are exactly the same, bit for bit.
+ * @param a First columns.
+ * @param b Second columns.
+ * @return True if they are.
+ */
+static bool sameColumns(const sensorColumns *a, const sensorColumns *b) {
+    if ((a->n_records != b->n_records) || (a->port_numbers != b->port_numbers)) {
+        return false;
+    }
+    for (uint8_t f = 0; f < (uint8_t)SENSOR_FIELD::COUNT; f++) {
+        const sensorColumn *column_a = &a->fields[f];
+        const sensorColumn *column_b = &b->fields[f];
+        if (column_a->validity != column_b->validity) {
+            return false;
+        }
+        for (uint8_t v = 0; v < MAX_FIELD_VALUES; v++) {
+            // compared as bytes, so -0.0 != 0.0 and NaN == NaN
+            if ((column_a->float_values[v].size() != column_b->float_values[v].size()) ||
+                (memcmp(column_a->float_values[v].data(), column_b->float_values[v].data(),
+                        column_a->float_values[v].size() * sizeof(float)) != 0) ||
+                (column_a->uint_values[v] != column_b->uint_values[v])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Times decodeFramesToColumns() with a kernel and checks it against the expected columns.
+ * @param kernel Kernel to use.
+ * @param frames Frames to decode.
+ * @param stride Bytes between frames.
+ * @param expected Columns from decodeBatchToColumns().
+ * @param baseline_fps Frames per second of decodeBatchToColumns().
+ * @return True if the columns matched.
+ */
+static bool runKernelBenchmark(EXTRACT_KERNEL kernel, const uint8_t *frames, size_t stride,
+                               const sensorColumns *expected, double baseline_fps) {
+    double best_fps = 0;
+    sensorColumns columns;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        decodeFramesToColumns(BENCHMARK_PORT, frames, stride, BENCHMARK_FRAMES, &columns, kernel);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double fps = BENCHMARK_FRAMES / elapsed.count();
+        best_fps = (fps > best_fps) ? fps : best_fps;
+    }
+
+    bool same = sameColumns(&columns, expected);
+    printf("frames, %-6s kernel: %10.0f frames/s (%.2fx) | %s\n", extractKernelName(kernel), best_fps,
+           best_fps / baseline_fps, same ? "identical" : "MISMATCH");
+    return same;
+}
+
+int main(void) {
+    std::mt19937 rng(2021);
+    std::uniform_real_distribution<float> unit(0, 1);
+    auto valid = [&]() { return unit(rng) >= 0.05f; };
+
+    // build the dataset, with the frames back to back in one buffer
+    const size_t stride = BENCHMARK_PORT.payloadLength();
+    std::vector<uint8_t> frames(BENCHMARK_FRAMES * stride + EXTRACT_PADDING);
+    std::vector<uplinkRecord> records(BENCHMARK_FRAMES);
+    for (size_t i = 0; i < BENCHMARK_FRAMES; i++) {
+        sensorData sensor_data = {};
+        sensor_data.battery_mv = { 3300 + 900 * unit(rng), valid() };
+        sensor_data.temperature = { -10 + 50 * unit(rng), valid() };
+        sensor_data.humidity = { 100 * unit(rng), valid() };
+        sensor_data.pressure = { (uint32_t)(95000 + 10000 * unit(rng)), valid() };
+        sensor_data.gas_resist = { (uint32_t)(500000 * unit(rng)), valid() };
+        sensor_data.location = { -34 + unit(rng), 151 + unit(rng), valid() };
+        uint8_t len = BENCHMARK_PORT.encodeSensorDataToPayload(&sensor_data, &frames[i * stride]);
+        records[i] = { BENCHMARK_PORT.port_number, len, &frames[i * stride] };
+    }
+    printf("%d PORT%d frames of %zu bytes\n", BENCHMARK_FRAMES, BENCHMARK_PORT.port_number, stride);
+
+    // baseline: the per record decoder
+    double baseline_fps = 0;
+    sensorColumns expected;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        decodeBatchToColumns(records.data(), records.size(), &expected);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        double fps = BENCHMARK_FRAMES / elapsed.count();
+        baseline_fps = (fps > baseline_fps) ? fps : baseline_fps;
+    }
+    printf("records, per record:   %10.0f frames/s\n", baseline_fps);
+
+    bool all_same = runKernelBenchmark(EXTRACT_KERNEL::SCALAR, frames.data(), stride, &expected, baseline_fps);
+    if (bestExtractKernel() >= EXTRACT_KERNEL::SSE) {
+        all_same &= runKernelBenchmark(EXTRACT_KERNEL::SSE, frames.data(), stride, &expected, baseline_fps);
+    }
+    if (bestExtractKernel() >= EXTRACT_KERNEL::AVX2) {
+        all_same &= runKernelBenchmark(EXTRACT_KERNEL::AVX2, frames.data(), stride, &expected, baseline_fps);
+    }
+    return all_same ? 0 : 1;
+}
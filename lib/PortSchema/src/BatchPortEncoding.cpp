@@ -0,0 +1,129 @@
+#include "BatchPortEncoding.h"
+
+#include <string.h>
+
+/**
+ * @brief Get the length of an encoded sample in a batch payload.
+ * @param port Port the sample is encoded with.
+ * @param buffer Payload buffer.
+ * @param buf_pos Start of the sample in the payload buffer.
+ * @param len Length of payload buffer.
+ * @return Sample length in bytes. For the PRESENCE_BITMAP payload format this is read from the bitmap of the sample.
+ */
+static uint8_t sampleLength(const portSchema *port, const uint8_t *buffer, uint8_t buf_pos, uint8_t len) {
+    if (port->payload_format != PAYLOAD_FORMAT::PRESENCE_BITMAP) {
+        return port->payloadLength();
+    }
+
+    const uint8_t bitmap_length = presenceBitmapLength(port->sensor_mask);
+    if ((buf_pos + bitmap_length) > len) {
+        return bitmap_length; // too short for the bitmap
+    }
+
+    const uint8_t *bitmap = &buffer[buf_pos];
+    uint8_t sample_length = bitmap_length;
+    uint8_t bit = 0;
+    for (uint16_t fields = port->sensor_mask; fields != 0; fields &= (fields - 1), bit++) {
+        if (bitmap[bit / 8] & (0x80 >> (bit % 8))) {
+            sample_length += SENSOR_FIELDS[__builtin_ctz(fields)].schema->n_bytes;
+        }
+    }
+    return sample_length;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BatchPortEncoder::BatchPortEncoder(portSchema port) : port(port) {}
+
+bool BatchPortEncoder::addSample(const sensorData *sensor_data, uint32_t timestamp) {
+    bool dropped = false;
+    if (n_samples >= MAX_BATCH_SAMPLES) {
+        log(LOG_LEVEL::WARN, "Port %d: batch full, dropping the oldest sample.", port.port_number);
+        n_samples--;
+        memmove(samples, &samples[1], n_samples * sizeof(samples[0]));
+        memmove(timestamps, &timestamps[1], n_samples * sizeof(timestamps[0]));
+        dropped = true;
+    }
+
+    samples[n_samples] = *sensor_data;
+    timestamps[n_samples] = timestamp;
+    n_samples++;
+    return !dropped;
+}
+
+uint8_t BatchPortEncoder::encodeBatchToPayload(uint8_t *payload_buffer, uint8_t max_payload_length) {
+    // fit checks use the longest sample, i.e. with every field valid
+    const uint8_t sample_length = port.payloadLength();
+    if ((n_samples == 0) || ((timestampSchema.n_bytes + sample_length) > max_payload_length)) {
+        return 0;
+    }
+
+    uint8_t buf_pos = timestampSchema.encodeData(timestamps[0], true, payload_buffer, 0);
+    buf_pos = port.encodeSensorDataToPayload(&samples[0], payload_buffer, buf_pos);
+
+    uint8_t s = 1;
+    for (; s < n_samples; s++) {
+        uint32_t offset = timestamps[s] - timestamps[s - 1];
+        if (offset > (uint32_t)timeOffsetSchema.max_value) {
+            break; // too long after the previous sample (or before it), so it starts the next payload
+        }
+        if ((buf_pos + timeOffsetSchema.n_bytes + sample_length) > max_payload_length) {
+            break;
+        }
+        buf_pos = timeOffsetSchema.encodeData(offset, true, payload_buffer, buf_pos);
+        buf_pos = port.encodeSensorDataToPayload(&samples[s], payload_buffer, buf_pos);
+    }
+
+    // remove the encoded samples
+    n_samples -= s;
+    memmove(samples, &samples[s], n_samples * sizeof(samples[0]));
+    memmove(timestamps, &timestamps[s], n_samples * sizeof(timestamps[0]));
+    return buf_pos;
+}
+
+uint8_t BatchPortEncoder::samplesPerPayload(uint8_t max_payload_length) const {
+    const uint8_t sample_length = port.payloadLength();
+    if ((timestampSchema.n_bytes + sample_length) > max_payload_length) {
+        return 0;
+    }
+    uint8_t n = 1 + (max_payload_length - timestampSchema.n_bytes - sample_length) /
+                        (timeOffsetSchema.n_bytes + sample_length);
+    return (n < MAX_BATCH_SAMPLES) ? n : MAX_BATCH_SAMPLES;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint8_t decodeBatchPayload(portSchema port, uint8_t *buffer, uint8_t len, sensorData *samples, uint32_t *timestamps,
+                           uint8_t max_samples) {
+    if (len < timestampSchema.n_bytes) {
+        return 0;
+    }
+
+    uint32_t timestamp = 0;
+    bool valid = false;
+    uint8_t buf_pos = timestampSchema.decodeData(&timestamp, &valid, buffer, 0);
+
+    uint8_t n = 0;
+    while ((n < max_samples) && (buf_pos < len)) {
+        if (n > 0) {
+            uint32_t offset = 0;
+            buf_pos = timeOffsetSchema.decodeData(&offset, &valid, buffer, buf_pos);
+            timestamp += offset;
+        }
+
+        uint8_t sample_length = sampleLength(&port, buffer, buf_pos, len);
+        if ((buf_pos + sample_length) > len) {
+            log(LOG_LEVEL::WARN, "Port %d: batch payload too short for sample %d.", port.port_number, n);
+            break;
+        }
+        samples[n] = port.decodePayloadToSensorData(buffer, buf_pos + sample_length, buf_pos);
+        timestamps[n] = timestamp;
+        buf_pos += sample_length;
+        n++;
+    }
+
+    if ((n == max_samples) && (buf_pos < len)) {
+        log(LOG_LEVEL::WARN, "Port %d: batch payload has more than %d samples.", port.port_number, max_samples);
+    }
+    return n;
+}
@@ -0,0 +1,88 @@
+#ifndef BATCH_PORT_ENCODING_H
+#define BATCH_PORT_ENCODING_H
+
+/**
+ * @file BatchPortEncoding.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief Batching of several timestamped sensor data samples of a port into one payload, as described in the README.
+ * The payload starts with the timestamp of the first sample (timestampSchema), followed by each sample encoded by the
+ * port, with the time since the previous sample (timeOffsetSchema) in between.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include "PortSchema.h" /**< Go here to see existing and define new sensor/port schemas. */
+
+#define MAX_BATCH_SAMPLES 16 /**< Max samples buffered by a BatchPortEncoder. */
+
+/**
+ * @brief BatchPortEncoder buffers timestamped sensor data samples of a port and packs as many as fit into a payload.
+ * A sample that is more than timeOffsetSchema.max_value seconds after the previous one starts the next payload.
+ */
+class BatchPortEncoder {
+  public:
+    /**
+     * @brief Construct a new BatchPortEncoder object.
+     * @param port Port each sample is encoded with, in its payload format.
+     */
+    BatchPortEncoder(portSchema port);
+
+    /**
+     * @brief Buffers a sample, if the buffer is full the oldest sample is dropped to make room.
+     * @param sensor_data Sensor data of the sample.
+     * @param timestamp Time the sample was taken in seconds, e.g. since boot or the unix epoch.
+     * @return True if buffered without dropping a sample, false if not.
+     */
+    bool addSample(const sensorData *sensor_data, uint32_t timestamp);
+
+    /**
+     * @brief Encodes as many of the buffered samples as fit, oldest first, and removes them from the buffer.
+     * @param payload_buffer Payload buffer for data to be written into, must fit max_payload_length bytes.
+     * @param max_payload_length Longest payload allowed, i.e. the max payload of the current datarate.
+     * @return Total length of data encoded to payload_buffer, 0 if there are no samples or the first doesn't fit.
+     */
+    uint8_t encodeBatchToPayload(uint8_t *payload_buffer, uint8_t max_payload_length);
+
+    /**
+     * @brief Get the number of samples that fit in a payload, with every field valid.
+     * @param max_payload_length Longest payload allowed.
+     * @return Number of samples.
+     */
+    uint8_t samplesPerPayload(uint8_t max_payload_length) const;
+
+    /**
+     * @brief Get the number of samples buffered and waiting to be sent.
+     * @return Number of samples.
+     */
+    inline uint8_t samplesWaiting(void) const { return n_samples; };
+
+    /**
+     * @brief Get the port each sample is encoded with.
+     * @return The port.
+     */
+    inline portSchema getPort(void) const { return port; };
+
+  private:
+    portSchema port;
+    sensorData samples[MAX_BATCH_SAMPLES];
+    uint32_t timestamps[MAX_BATCH_SAMPLES];
+    uint8_t n_samples = 0;
+};
+
+/**
+ * @brief Decodes a batch payload into its samples.
+ * @param port Port each sample is encoded with, must match the BatchPortEncoder.
+ * @param buffer Payload buffer to be decoded.
+ * @param len Length of payload buffer.
+ * @param samples Resulting decoded sensor data of each sample.
+ * @param timestamps Resulting timestamp of each sample.
+ * @param max_samples Length of samples and timestamps.
+ * @return Number of samples decoded.
+ */
+uint8_t decodeBatchPayload(portSchema port, uint8_t *buffer, uint8_t len, sensorData *samples, uint32_t *timestamps,
+                           uint8_t max_samples);
+
+#endif // BATCH_PORT_ENCODING_H
@@ -0,0 +1,288 @@
+#include "DeltaPortEncoding.h"
+
+/**
+ * @brief Checks the validity flag of a sensor field.
+ * @param field Sensor field to check.
+ * @param sensor_data Sensor data holding the field.
+ * @return True if the field's data is valid.
+ */
+static bool fieldIsValid(const sensorField *field, const sensorData *sensor_data) {
+    return *(const bool *)((const uint8_t *)sensor_data + field->valid_offset);
+}
+
+/**
+ * @brief Get the number of bytes per value of a sensor port schema in the FIXED payload format.
+ * @param schema Sensor port schema.
+ * @return Bytes per value.
+ */
+static uint8_t valueBytes(const sensorPortSchema *schema) {
+    return schema->n_bytes / schema->n_values;
+}
+
+/**
+ * @brief Sign extends an n_bits long two's complement value to 32 bits.
+ * @param bits Decoded bits.
+ * @param n_bits Number of bits of the value.
+ * @return Signed value.
+ */
+static int32_t signExtendBits(uint32_t bits, uint8_t n_bits) {
+    return (int32_t)(bits << (32 - n_bits)) >> (32 - n_bits);
+}
+
+/**
+ * @brief Get the delta encoded to indicate an invalid value in a delta frame.
+ * Like the 0x7F7F7F7F of signed values in the FIXED payload format, it is the largest positive value.
+ * @param delta_bits Bits per delta.
+ * @return The invalid delta.
+ */
+static int32_t invalidDelta(uint8_t delta_bits) {
+    return (1L << (delta_bits - 1)) - 1;
+}
+
+/**
+ * @brief Get the length of a delta frame of the given port.
+ * @param sensor_mask Bitmask of the sensor fields of the port.
+ * @return Payload length in bytes.
+ */
+static uint8_t deltaFrameLength(uint16_t sensor_mask) {
+    uint16_t n_bits = 0;
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        const sensorPortSchema *schema = SENSOR_FIELDS[__builtin_ctz(fields)].schema;
+        n_bits += schema->n_values * schema->delta_bits;
+    }
+    return DELTA_FRAME_HEADER_LENGTH + (n_bits + 7) / 8;
+}
+
+/**
+ * @brief Scales a value of the sensor data to its fixed-point value, as the decoder will read it from a keyframe.
+ * i.e. the same scaling as sensorPortSchema::encodeData(), cut down to the bytes of the value.
+ * @param field Sensor field of the value.
+ * @param sensor_data Sensor data holding the field.
+ * @param v Index of the value of the sensor field.
+ * @return Fixed-point value.
+ */
+static int32_t toFixedPoint(const sensorField *field, const sensorData *sensor_data, uint8_t v) {
+    const sensorPortSchema *schema = field->schema;
+    const uint8_t *value = (const uint8_t *)sensor_data + field->value_offsets[v];
+    uint32_t bits = 0;
+    if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+        bits = (uint32_t)scaleToFixedPoint(*(const float *)value, schema->scale_num, schema->scale_den);
+    } else {
+        bits = scaleToFixedPoint(*(const uint32_t *)value, schema->scale_num, schema->scale_den);
+    }
+
+    if (schema->is_signed) {
+        return signExtend(bits, valueBytes(schema));
+    }
+    return (int32_t)(bits & invalidFieldValue(false, valueBytes(schema)));
+}
+
+/**
+ * @brief Reads the fixed-point values of a keyframe into the frame state.
+ * @param sensor_mask Bitmask of the sensor fields of the port.
+ * @param buffer Keyframe payload.
+ * @param buf_pos Start of the sensor data in the keyframe, i.e. after the header.
+ * @param state Resulting frame state.
+ */
+static void readKeyframe(uint16_t sensor_mask, const uint8_t *buffer, uint8_t buf_pos, deltaFrameState *state) {
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        uint8_t f = __builtin_ctz(fields);
+        const sensorPortSchema *schema = SENSOR_FIELDS[f].schema;
+        uint8_t data_size = valueBytes(schema);
+
+        for (uint8_t v = 0; v < schema->n_values; v++) {
+            uint32_t bits = loadBits(buffer, buf_pos * 8, data_size * 8);
+            if (v == 0) {
+                // all values of a field are invalid together, so the first is enough to tell
+                state->is_valid[f] = (bits != invalidFieldValue(schema->is_signed, data_size));
+            }
+            state->values[f * MAX_FIELD_VALUES + v] = schema->is_signed ? signExtend(bits, data_size) : (int32_t)bits;
+            buf_pos += data_size;
+        }
+    }
+}
+
+/**
+ * @brief Encodes the deltas of the sensor data from the frame state into a delta frame (after the header).
+ * The frame state is only updated if the delta frame can be sent.
+ * @param sensor_mask Bitmask of the sensor fields of the port.
+ * @param sensor_data Sensor data to be encoded.
+ * @param state Frame state of the previous frame, updated to this frame.
+ * @param payload_buffer Payload buffer for data to be written into.
+ * @return Total length of data encoded to payload_buffer, or 0 if a keyframe must be sent instead.
+ */
+static uint8_t encodeDeltaFrame(uint16_t sensor_mask, const sensorData *sensor_data, deltaFrameState *state,
+                                uint8_t *payload_buffer) {
+    deltaFrameState next_state = *state;
+    int32_t deltas[MAX_DELTA_VALUES] = {};
+
+    // check every delta fits before writing any of them
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        uint8_t f = __builtin_ctz(fields);
+        const sensorField *field = &SENSOR_FIELDS[f];
+        const uint8_t delta_bits = field->schema->delta_bits;
+        const int32_t max_delta = invalidDelta(delta_bits) - 1;
+        const int32_t min_delta = -(1L << (delta_bits - 1));
+        bool valid = fieldIsValid(field, sensor_data);
+
+        if (valid && !state->is_valid[f]) {
+            return 0; // nothing to take a delta from
+        }
+        next_state.is_valid[f] = valid;
+
+        for (uint8_t v = 0; v < field->schema->n_values; v++) {
+            uint8_t i = f * MAX_FIELD_VALUES + v;
+            if (!valid) {
+                deltas[i] = invalidDelta(delta_bits);
+                continue;
+            }
+            int32_t value = toFixedPoint(field, sensor_data, v);
+            deltas[i] = (int32_t)((uint32_t)value - (uint32_t)state->values[i]);
+            if ((deltas[i] < min_delta) || (deltas[i] > max_delta)) {
+                return 0; // the change is too big for a delta
+            }
+            next_state.values[i] = value;
+        }
+    }
+
+    uint16_t bit_pos = DELTA_FRAME_HEADER_LENGTH * 8;
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        uint8_t f = __builtin_ctz(fields);
+        const sensorPortSchema *schema = SENSOR_FIELDS[f].schema;
+        for (uint8_t v = 0; v < schema->n_values; v++) {
+            storeBits(payload_buffer, bit_pos, (uint32_t)deltas[f * MAX_FIELD_VALUES + v], schema->delta_bits);
+            bit_pos += schema->delta_bits;
+        }
+    }
+    // pad the last byte with 0's
+    if ((bit_pos % 8) != 0) {
+        storeBits(payload_buffer, bit_pos, 0, 8 - (bit_pos % 8));
+    }
+
+    *state = next_state;
+    return (uint8_t)((bit_pos + 7) / 8);
+}
+
+/**
+ * @brief Undoes the fixed-point scaling of the frame state to give the sensor data.
+ * @param sensor_mask Bitmask of the sensor fields of the port.
+ * @param state Frame state.
+ * @param sensor_data Resulting sensor data.
+ */
+static void stateToSensorData(uint16_t sensor_mask, const deltaFrameState *state, sensorData *sensor_data) {
+    uint8_t *data = (uint8_t *)sensor_data;
+
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        uint8_t f = __builtin_ctz(fields);
+        const sensorField *field = &SENSOR_FIELDS[f];
+        const sensorPortSchema *schema = field->schema;
+
+        *(bool *)(data + field->valid_offset) = state->is_valid[f];
+        if (!state->is_valid[f]) {
+            continue;
+        }
+
+        for (uint8_t v = 0; v < schema->n_values; v++) {
+            int32_t value = state->values[f * MAX_FIELD_VALUES + v];
+            uint8_t *sensor_value = data + field->value_offsets[v];
+            if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+                if (schema->is_signed) {
+                    scaleFromFixedPoint(value, (float *)sensor_value, schema->scale_num, schema->scale_den);
+                } else {
+                    scaleFromFixedPoint((uint32_t)value, (float *)sensor_value, schema->scale_num, schema->scale_den);
+                }
+            } else {
+                scaleFromFixedPoint((uint32_t)value, (uint32_t *)sensor_value, schema->scale_num, schema->scale_den);
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeltaPortEncoder::DeltaPortEncoder(portSchema port, uint8_t keyframe_interval)
+    : port{ port.port_number, port.sensor_mask, PAYLOAD_FORMAT::FIXED }, keyframe_interval(keyframe_interval) {
+    if ((keyframe_interval == 0) || (keyframe_interval > DELTA_FRAME_COUNTER_MASK)) {
+        log(LOG_LEVEL::WARN, "Keyframe interval must be 1 - %d, using %d.", DELTA_FRAME_COUNTER_MASK,
+            DEFAULT_KEYFRAME_INTERVAL);
+        this->keyframe_interval = DEFAULT_KEYFRAME_INTERVAL;
+    }
+}
+
+uint8_t DeltaPortEncoder::encodeSensorDataToPayload(sensorData *sensor_data, uint8_t *payload_buffer) {
+    uint8_t header = frame_counter & DELTA_FRAME_COUNTER_MASK;
+    frame_counter++;
+
+    // send a delta frame if a keyframe isn't due and all of the deltas fit
+    if (!keyframe_due && ((frames_since_keyframe + 1) < keyframe_interval)) {
+        uint8_t payload_length = encodeDeltaFrame(port.sensor_mask, sensor_data, &state, payload_buffer);
+        if (payload_length > 0) {
+            payload_buffer[0] = header;
+            frames_since_keyframe++;
+            return payload_length;
+        }
+    }
+
+    payload_buffer[0] = header | DELTA_FRAME_KEYFRAME_FLAG;
+    uint8_t payload_length = port.encodeSensorDataToPayload(sensor_data, payload_buffer, DELTA_FRAME_HEADER_LENGTH);
+    // the state is read back from the keyframe so it matches the decoder's exactly
+    readKeyframe(port.sensor_mask, payload_buffer, DELTA_FRAME_HEADER_LENGTH, &state);
+    frames_since_keyframe = 0;
+    keyframe_due = false;
+    return payload_length;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeltaPortDecoder::DeltaPortDecoder(portSchema port) : port{ port.port_number, port.sensor_mask, PAYLOAD_FORMAT::FIXED } {}
+
+bool DeltaPortDecoder::decodePayloadToSensorData(uint8_t *buffer, uint8_t len, sensorData *sensor_data) {
+    *sensor_data = sensorData{};
+    if (len < DELTA_FRAME_HEADER_LENGTH) {
+        return false;
+    }
+    uint8_t frame_counter = buffer[0] & DELTA_FRAME_COUNTER_MASK;
+
+    if (buffer[0] & DELTA_FRAME_KEYFRAME_FLAG) {
+        if (len < (DELTA_FRAME_HEADER_LENGTH + port.payloadLength())) {
+            synced = false;
+            return false;
+        }
+        readKeyframe(port.sensor_mask, buffer, DELTA_FRAME_HEADER_LENGTH, &state);
+    } else {
+        // a delta frame can only be decoded if the frame before it was
+        if (!synced || (frame_counter != ((last_frame_counter + 1) & DELTA_FRAME_COUNTER_MASK))) {
+            if (synced) {
+                log(LOG_LEVEL::WARN, "Port %d: frame %d lost, waiting for the next keyframe.", port.port_number,
+                    (last_frame_counter + 1) & DELTA_FRAME_COUNTER_MASK);
+            }
+            synced = false;
+            return false;
+        }
+        if (len < deltaFrameLength(port.sensor_mask)) {
+            synced = false;
+            return false;
+        }
+
+        uint16_t bit_pos = DELTA_FRAME_HEADER_LENGTH * 8;
+        for (uint16_t fields = port.sensor_mask; fields != 0; fields &= (fields - 1)) {
+            uint8_t f = __builtin_ctz(fields);
+            const uint8_t delta_bits = SENSOR_FIELDS[f].schema->delta_bits;
+            for (uint8_t v = 0; v < SENSOR_FIELDS[f].schema->n_values; v++) {
+                int32_t delta = signExtendBits(loadBits(buffer, bit_pos, delta_bits), delta_bits);
+                bit_pos += delta_bits;
+                if (delta == invalidDelta(delta_bits)) {
+                    state.is_valid[f] = false;
+                } else {
+                    uint8_t i = f * MAX_FIELD_VALUES + v;
+                    state.values[i] = (int32_t)((uint32_t)state.values[i] + (uint32_t)delta);
+                }
+            }
+        }
+    }
+
+    synced = true;
+    last_frame_counter = frame_counter;
+    stateToSensorData(port.sensor_mask, &state, sensor_data);
+    return true;
+}
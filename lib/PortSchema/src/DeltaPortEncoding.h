@@ -0,0 +1,123 @@
+#ifndef DELTA_PORT_ENCODING_H
+#define DELTA_PORT_ENCODING_H
+
+/**
+ * @file DeltaPortEncoding.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief Delta/keyframe encoding of consecutive payloads of a port, as described in the README.
+ * Every keyframe_interval frames a keyframe with the full (FIXED payload format) sensor data is sent, in between only
+ * the small signed change (delta) of each value since the previous frame is sent, in delta_bits of its sensor port
+ * schema.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include "PortSchema.h" /**< Go here to see existing and define new sensor/port schemas. */
+
+// Frame header: 1 byte at the start of every delta encoded payload
+#define DELTA_FRAME_KEYFRAME_FLAG  0x80 /**< Set if the frame is a keyframe, clear if it is a delta frame. */
+#define DELTA_FRAME_COUNTER_MASK   0x7F /**< Frame counter, incremented every frame (keyframe or not). */
+#define DELTA_FRAME_HEADER_LENGTH  1
+
+#define DEFAULT_KEYFRAME_INTERVAL 16 /**< Send a keyframe every 16 frames, i.e. 8 minutes at 30 s per frame. */
+
+#define MAX_DELTA_VALUES ((uint8_t)SENSOR_FIELD::COUNT * MAX_FIELD_VALUES)
+
+/**
+ * @brief The fixed-point sensor data of the last frame, as the decoder will see it.
+ * Indexed by SENSOR_FIELD (and value for the values), only the fields of the port are used.
+ */
+struct deltaFrameState {
+    int32_t values[MAX_DELTA_VALUES];
+    bool is_valid[(uint8_t)SENSOR_FIELD::COUNT];
+};
+
+/**
+ * @brief DeltaPortEncoder encodes the sensor data of a port into keyframes and delta frames.
+ * It keeps the state of the last frame so must be used for every payload of the port, in order.
+ * A keyframe is also sent instead of a delta frame whenever a delta doesn't fit in the delta_bits of its schema, or a
+ * sensor's data becomes valid again.
+ */
+class DeltaPortEncoder {
+  public:
+    /**
+     * @brief Construct a new DeltaPortEncoder object.
+     * @param port Port to encode, its payload format is ignored as keyframes are always FIXED.
+     * @param keyframe_interval Send a keyframe at least every keyframe_interval frames (1 - 127).
+     */
+    DeltaPortEncoder(portSchema port, uint8_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+    /**
+     * @brief Encodes the given sensor data into a keyframe or delta frame.
+     * @param sensor_data Sensor data to be encoded.
+     * @param payload_buffer Payload buffer for data to be written into, must fit maxPayloadLength() bytes.
+     * @return Total length of data encoded to payload_buffer.
+     */
+    uint8_t encodeSensorDataToPayload(sensorData *sensor_data, uint8_t *payload_buffer);
+
+    /**
+     * @brief Makes the next frame a keyframe, e.g. after (re)joining the network.
+     */
+    inline void forceKeyframe(void) { keyframe_due = true; };
+
+    /**
+     * @brief Get the longest payload, i.e. a keyframe.
+     * @return Payload length in bytes.
+     */
+    inline uint8_t maxPayloadLength(void) const { return DELTA_FRAME_HEADER_LENGTH + port.payloadLength(); };
+
+    /**
+     * @brief Get the port being encoded.
+     * @return The port (in the FIXED payload format).
+     */
+    inline portSchema getPort(void) const { return port; };
+
+  private:
+    portSchema port;
+    uint8_t keyframe_interval;
+    uint8_t frame_counter = 0;
+    uint8_t frames_since_keyframe = 0;
+    bool keyframe_due = true; // the first frame must be a keyframe
+    deltaFrameState state = {};
+};
+
+/**
+ * @brief DeltaPortDecoder decodes the keyframes and delta frames of one port of one device.
+ * It keeps the state of the last frame, so a lost frame (including a lost keyframe) is detected by a gap in the frame
+ * counter, after which delta frames can't be decoded until the next keyframe.
+ */
+class DeltaPortDecoder {
+  public:
+    /**
+     * @brief Construct a new DeltaPortDecoder object.
+     * @param port Port to decode, must match the DeltaPortEncoder.
+     */
+    DeltaPortDecoder(portSchema port);
+
+    /**
+     * @brief Decodes the given keyframe or delta frame into the sensor data.
+     * @param buffer Payload buffer to be decoded.
+     * @param len Length of payload buffer.
+     * @param sensor_data Resulting decoded sensor data.
+     * @return True if decoded. False if not, i.e. a delta frame without the frame before it or a payload that is too
+     * short. In that case sensor_data is all invalid.
+     */
+    bool decodePayloadToSensorData(uint8_t *buffer, uint8_t len, sensorData *sensor_data);
+
+    /**
+     * @brief Checks if delta frames can currently be decoded.
+     * @return True if the last frame was decoded, false if waiting for a keyframe.
+     */
+    inline bool isSynced(void) const { return synced; };
+
+  private:
+    portSchema port;
+    uint8_t last_frame_counter = 0;
+    bool synced = false; // the first frame must be a keyframe
+    deltaFrameState state = {};
+};
+
+#endif // DELTA_PORT_ENCODING_H
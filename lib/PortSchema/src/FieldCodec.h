@@ -0,0 +1,230 @@
+#ifndef FIELD_CODEC_H
+#define FIELD_CODEC_H
+
+/**
+ * @file FieldCodec.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief The building blocks of the sensor port schema encoding: fixed-point scaling and MSB (big-endian) byte
+ * packing, plus the bit packing used by the BIT_PACKED payload format. FieldCodec is the compile time form of a
+ * sensorPortSchema, with every size and scale known to the compiler it encodes and decodes with straight-line code (no
+ * loops or branches on the schema).
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <stdint.h>
+
+#define MAX_VALUE_BYTES 4 /**< Max bytes per encoded value, i.e. 32 bit. */
+
+/**
+ * @brief MSB byte encoding/decoding of N bytes, unrolled at compile time.
+ * @tparam N Number of bytes.
+ */
+template <uint8_t N> struct bigEndian {
+    static inline void store(uint8_t *buffer, uint32_t bits) {
+        buffer[0] = (uint8_t)(bits >> (8 * (N - 1)));
+        bigEndian<N - 1>::store(buffer + 1, bits);
+    }
+
+    static inline uint32_t load(const uint8_t *buffer) {
+        return ((uint32_t)buffer[0] << (8 * (N - 1))) | bigEndian<N - 1>::load(buffer + 1);
+    }
+};
+
+template <> struct bigEndian<0> {
+    static inline void store(uint8_t *buffer, uint32_t bits) {
+        (void)buffer;
+        (void)bits;
+    }
+
+    static inline uint32_t load(const uint8_t *buffer) {
+        (void)buffer;
+        return 0;
+    }
+};
+
+/**
+ * @brief MSB bit encodes the low n_bits of bits into the buffer, starting at any bit (not just a byte boundary).
+ * Only the n_bits written to are changed, the rest of each byte is kept.
+ * @param buffer Buffer for the data to be written into.
+ * @param bit_pos Start writing from this bit, 0 being the MSB of buffer[0].
+ * @param bits Bits of the value.
+ * @param n_bits Number of bits to write (1 - 32).
+ */
+inline void storeBits(uint8_t *buffer, uint16_t bit_pos, uint32_t bits, uint8_t n_bits) {
+    while (n_bits > 0) {
+        uint8_t free_bits = 8 - (bit_pos % 8); // bits left in this byte
+        uint8_t n = (n_bits < free_bits) ? n_bits : free_bits;
+        uint8_t mask = (uint8_t)((0xFFU >> (8 - n)) << (free_bits - n));
+        uint8_t chunk = (uint8_t)(((bits >> (n_bits - n)) << (free_bits - n)) & mask);
+        buffer[bit_pos / 8] = (uint8_t)((buffer[bit_pos / 8] & ~mask) | chunk);
+        bit_pos += n;
+        n_bits -= n;
+    }
+}
+
+/**
+ * @brief MSB bit decodes n_bits from the buffer, starting at any bit (not just a byte boundary).
+ * @param buffer Buffer that data will be decoded from.
+ * @param bit_pos Start reading from this bit, 0 being the MSB of buffer[0].
+ * @param n_bits Number of bits to read (1 - 32).
+ * @return Bits of the value.
+ */
+inline uint32_t loadBits(const uint8_t *buffer, uint16_t bit_pos, uint8_t n_bits) {
+    uint32_t bits = 0;
+    while (n_bits > 0) {
+        uint8_t free_bits = 8 - (bit_pos % 8);
+        uint8_t n = (n_bits < free_bits) ? n_bits : free_bits;
+        uint8_t chunk = (uint8_t)((buffer[bit_pos / 8] >> (free_bits - n)) & (0xFFU >> (8 - n)));
+        bits = (bits << n) | chunk;
+        bit_pos += n;
+        n_bits -= n;
+    }
+    return bits;
+}
+
+/**
+ * @brief Get the value encoded to indicate invalid data.
+ * A segment of 0x7F7F7F7F (signed) or 0xFFFFFFFF (unsigned) that fills the bytes of the value.
+ * @param is_signed Value has a sign.
+ * @param value_bytes Number of bytes of the value.
+ * @return The invalid value.
+ */
+constexpr uint32_t invalidFieldValue(bool is_signed, uint8_t value_bytes) {
+    return (is_signed ? 0x7F7F7F7FUL : 0xFFFFFFFFUL) >> ((MAX_VALUE_BYTES - value_bytes) * 8);
+}
+
+/**
+ * @brief Sign extends a value_bytes long two's complement value to 32 bits.
+ * @param bits Decoded bits.
+ * @param value_bytes Number of bytes of the value.
+ * @return Signed value.
+ */
+inline int32_t signExtend(uint32_t bits, uint8_t value_bytes) {
+    uint8_t unused_bits = (MAX_VALUE_BYTES - value_bytes) * 8;
+    return (int32_t)(bits << unused_bits) >> unused_bits;
+}
+
+/**
+ * @brief Scales the given sensor data by scale_num/scale_den into the fixed-point integer that is encoded.
+ * The overloads keep to the cheapest maths for the type: single-precision float for float data (the Cortex-M4F has no
+ * double-precision FPU) and integer for integer data. Any decimal values not captured by the scale are discarded
+ * (truncated towards zero).
+ * @param sensor_data Sensor data to scale.
+ * @param scale_num Scale factor numerator.
+ * @param scale_den Scale factor denominator.
+ * @return Scaled sensor data.
+ */
+inline int32_t scaleToFixedPoint(float sensor_data, uint32_t scale_num, uint32_t scale_den) {
+    float scaled = sensor_data * (float)scale_num;
+    if (scale_den != 1) {
+        scaled /= (float)scale_den;
+    }
+    return (int32_t)scaled;
+}
+
+inline int32_t scaleToFixedPoint(int sensor_data, uint32_t scale_num, uint32_t scale_den) {
+    int64_t scaled = (int64_t)sensor_data * scale_num;
+    if (scale_den != 1) {
+        scaled /= scale_den;
+    }
+    return (int32_t)scaled;
+}
+
+inline uint32_t scaleToFixedPoint(uint32_t sensor_data, uint32_t scale_num, uint32_t scale_den) {
+    uint64_t scaled = (uint64_t)sensor_data * scale_num;
+    if (scale_den != 1) {
+        scaled /= scale_den;
+    }
+    return (uint32_t)scaled;
+}
+
+/**
+ * @brief Undoes the fixed-point scaling of the decoded integer to give the sensor data.
+ * Integer sensor data only uses integer maths, and float sensor data only single-precision float maths.
+ * @param fixed_point Decoded (and sign extended if needed) integer from the payload.
+ * @param sensor_data Resulting sensor data.
+ * @param scale_num Scale factor numerator.
+ * @param scale_den Scale factor denominator.
+ */
+template <typename T, typename F>
+inline void scaleFromFixedPoint(F fixed_point, T *sensor_data, uint32_t scale_num, uint32_t scale_den) {
+    if (scale_num == scale_den) {
+        *sensor_data = (T)fixed_point;
+    } else {
+        *sensor_data = (T)(((int64_t)fixed_point * scale_den) / (int64_t)scale_num);
+    }
+}
+
+template <typename F>
+inline void scaleFromFixedPoint(F fixed_point, float *sensor_data, uint32_t scale_num, uint32_t scale_den) {
+    float value = (float)fixed_point;
+    if (scale_den != 1) {
+        value *= (float)scale_den;
+    }
+    *sensor_data = value / (float)scale_num;
+}
+
+/**
+ * @brief FieldCodec is a sensorPortSchema with its settings as template parameters.
+ * See sensorPortSchema for the meaning of each, and SchemaCodec in SensorPortSchema.h to get the FieldCodec of an
+ * existing sensorPortSchema.
+ * @tparam Bytes Total length in payload - split equally amongst Values.
+ * @tparam Values Number of values sent for sensor data.
+ * @tparam ScaleNum Scale factor numerator.
+ * @tparam ScaleDen Scale factor denominator.
+ * @tparam Signed Value has a sign and hence can be negative.
+ */
+template <uint8_t Bytes, uint8_t Values, uint32_t ScaleNum, uint32_t ScaleDen, bool Signed> struct FieldCodec {
+    static constexpr uint8_t VALUE_BYTES = Bytes / Values;                           /**< Bytes per value. */
+    static constexpr uint32_t INVALID_VALUE = invalidFieldValue(Signed, VALUE_BYTES); /**< Sent for invalid data. */
+
+    static_assert((Values > 0) && (Bytes % Values == 0), "Bytes must split equally amongst Values.");
+    static_assert((VALUE_BYTES > 0) && (VALUE_BYTES <= MAX_VALUE_BYTES), "Values must be 1 to 4 bytes.");
+    static_assert((ScaleNum > 0) && (ScaleDen > 0), "Scale factor must be positive.");
+
+    /**
+     * @brief Byte encodes one value into the buffer.
+     * If the data is invalid INVALID_VALUE is encoded instead, the selection doesn't need a branch.
+     * @param sensor_data Sensor data to encode (float, int or uint32_t).
+     * @param valid Validity of given sensor data.
+     * @param buffer Buffer for the data to be written into.
+     * @return Position in the buffer after the encoded value.
+     */
+    template <typename T> static inline uint8_t *encode(T sensor_data, bool valid, uint8_t *buffer) {
+        uint32_t bits = (uint32_t)scaleToFixedPoint(sensor_data, ScaleNum, ScaleDen);
+        bigEndian<VALUE_BYTES>::store(buffer, valid ? bits : INVALID_VALUE);
+        return buffer + VALUE_BYTES;
+    }
+
+    /**
+     * @brief Byte decodes one value from the buffer.
+     * If the sensor data is not valid the valid flag will be set to false and no data will be decoded to sensor_data.
+     * @param sensor_data Resulting decoded sensor data (float, int, uint8_t, uint16_t or uint32_t).
+     * @param valid Validity of the decoded sensor data.
+     * @param buffer Buffer that data will be decoded from.
+     * @return Position in the buffer after the decoded value.
+     */
+    template <typename T> static inline const uint8_t *decode(T *sensor_data, bool *valid, const uint8_t *buffer) {
+        uint32_t bits = bigEndian<VALUE_BYTES>::load(buffer);
+        *valid = (bits != INVALID_VALUE);
+        if (*valid) {
+            if (Signed) {
+                scaleFromFixedPoint(signExtend(bits, VALUE_BYTES), sensor_data, ScaleNum, ScaleDen);
+            } else {
+                scaleFromFixedPoint(bits, sensor_data, ScaleNum, ScaleDen);
+            }
+        }
+        return buffer + VALUE_BYTES;
+    }
+};
+
+template <uint8_t Bytes, uint8_t Values, uint32_t ScaleNum, uint32_t ScaleDen, bool Signed>
+constexpr uint8_t FieldCodec<Bytes, Values, ScaleNum, ScaleDen, Signed>::VALUE_BYTES;
+template <uint8_t Bytes, uint8_t Values, uint32_t ScaleNum, uint32_t ScaleDen, bool Signed>
+constexpr uint32_t FieldCodec<Bytes, Values, ScaleNum, ScaleDen, Signed>::INVALID_VALUE;
+
+#endif // FIELD_CODEC_H
@@ -0,0 +1,132 @@
+#include "PayloadPlanner.h"
+
+#include <string.h>
+
+/**
+ * @brief Finds the port in PORT_REGISTRY with the most of the given port's fields that fits.
+ * Only ports with no other fields are considered, ties go to the longer payload.
+ * @param port Port that doesn't fit.
+ * @param max_payload_length Max payload of the datarate.
+ * @return The smaller port, or PORTERROR if none fit.
+ */
+static portSchema smallerPort(portSchema port, uint8_t max_payload_length) {
+    portSchema smaller_port = PORTERROR;
+    int best_fields = 0;
+    uint8_t best_length = 0;
+
+    for (size_t p = 0; p < sizeof(PORT_REGISTRY) / sizeof(PORT_REGISTRY[0]); p++) {
+        const portSchema *candidate = &PORT_REGISTRY[p];
+        if ((candidate->sensor_mask & ~port.sensor_mask) != 0) {
+            continue; // sends a field the port doesn't
+        }
+        uint8_t length = candidate->payloadLength();
+        int fields = __builtin_popcount(candidate->sensor_mask);
+        if ((length > max_payload_length) || (fields < best_fields) ||
+            ((fields == best_fields) && (length <= best_length))) {
+            continue;
+        }
+        smaller_port = *candidate;
+        best_fields = fields;
+        best_length = length;
+    }
+    return smaller_port;
+}
+
+payloadPlan planPayload(portSchema port, uint8_t max_payload_length, PLAN_FALLBACK fallback) {
+    payloadPlan plan = { PAYLOAD_PLAN::SEND, port, port.payloadLength(), max_payload_length, 1 };
+    if (plan.payload_length <= max_payload_length) {
+        return plan;
+    }
+
+    if (fallback == PLAN_FALLBACK::FRAGMENT) {
+        plan.n_fragments = fragmentCount(plan.payload_length, max_payload_length);
+        plan.plan = (plan.n_fragments > 0) ? PAYLOAD_PLAN::FRAGMENT : PAYLOAD_PLAN::NONE;
+    } else {
+        plan.port = smallerPort(port, max_payload_length);
+        plan.plan = (plan.port == PORTERROR) ? PAYLOAD_PLAN::NONE : PAYLOAD_PLAN::SMALLER_PORT;
+    }
+
+    if (plan.plan == PAYLOAD_PLAN::NONE) {
+        log(LOG_LEVEL::WARN, "Port %d: %d byte payload doesn't fit in %d bytes.", port.port_number, plan.payload_length,
+            max_payload_length);
+    }
+    return plan;
+}
+
+uint8_t fragmentCount(uint8_t payload_length, uint8_t max_payload_length) {
+    // the first fragment also carries the port number
+    if (max_payload_length <= (FRAGMENT_HEADER_LENGTH + 1)) {
+        return 0;
+    }
+    uint8_t first_length = max_payload_length - FRAGMENT_HEADER_LENGTH - 1;
+    if (payload_length <= first_length) {
+        return 1;
+    }
+    uint8_t rest_length = max_payload_length - FRAGMENT_HEADER_LENGTH;
+    int n_fragments = 1 + (payload_length - first_length + rest_length - 1) / rest_length;
+    return (n_fragments <= MAX_FRAGMENTS) ? (uint8_t)n_fragments : 0;
+}
+
+uint8_t encodeFragment(const uint8_t *payload, uint8_t payload_length, uint8_t port_number, uint8_t fragment,
+                       uint8_t max_payload_length, uint8_t *fragment_buffer) {
+    uint8_t n_fragments = fragmentCount(payload_length, max_payload_length);
+    if (fragment >= n_fragments) {
+        return 0;
+    }
+
+    uint8_t buf_pos = 0;
+    fragment_buffer[buf_pos++] = (uint8_t)((fragment << 4) | (n_fragments - 1));
+
+    uint8_t first_length = max_payload_length - FRAGMENT_HEADER_LENGTH - 1;
+    uint8_t start = 0;
+    uint8_t length = 0;
+    if (fragment == 0) {
+        fragment_buffer[buf_pos++] = port_number;
+        length = (payload_length < first_length) ? payload_length : first_length;
+    } else {
+        uint8_t rest_length = max_payload_length - FRAGMENT_HEADER_LENGTH;
+        start = first_length + (fragment - 1) * rest_length;
+        length = ((payload_length - start) < rest_length) ? (payload_length - start) : rest_length;
+    }
+
+    memcpy(&fragment_buffer[buf_pos], &payload[start], length);
+    return buf_pos + length;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FragmentReassembler::addFragment(const uint8_t *buffer, uint8_t len) {
+    if (len <= FRAGMENT_HEADER_LENGTH) {
+        next_fragment = 0;
+        return false;
+    }
+    uint8_t fragment = buffer[0] >> 4;
+    uint8_t last_fragment = buffer[0] & 0x0F;
+    uint8_t buf_pos = FRAGMENT_HEADER_LENGTH;
+
+    if (fragment == 0) {
+        port_number = buffer[buf_pos++];
+        payload_length = 0;
+    } else if (fragment != next_fragment) {
+        if (next_fragment != 0) {
+            log(LOG_LEVEL::WARN, "Fragment %d lost, dropping the payload.", next_fragment);
+        }
+        next_fragment = 0;
+        return false;
+    }
+
+    uint8_t length = len - buf_pos;
+    if ((payload_length + length) > MAX_FRAGMENTED_PAYLOAD_LENGTH) {
+        next_fragment = 0;
+        return false;
+    }
+    memcpy(&payload[payload_length], &buffer[buf_pos], length);
+    payload_length += length;
+
+    if (fragment == last_fragment) {
+        next_fragment = 0;
+        return true;
+    }
+    next_fragment = fragment + 1;
+    return false;
+}
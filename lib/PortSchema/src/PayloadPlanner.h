@@ -0,0 +1,122 @@
+#ifndef PAYLOAD_PLANNER_H
+#define PAYLOAD_PLANNER_H
+
+/**
+ * @file PayloadPlanner.h
+ * @author Kalina Knight (kalina.knight77@gmail.com)
+ * @brief Checks a port's payload fits the max payload of the datarate before it is sent, as described in the README.
+ * If it doesn't fit the payload is either split into numbered fragments or a smaller port is sent instead.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include "PortSchema.h" /**< Go here to see existing and define new sensor/port schemas. */
+
+#define FRAGMENT_PORT_NUMBER 200 /**< Port number that every fragment is sent on. */
+#define FRAGMENT_HEADER_LENGTH 1 /**< Fragment index (upper nibble) & last fragment index (lower nibble). */
+#define MAX_FRAGMENTS 16         /**< Max fragments per payload, limited by the nibbles of the header. */
+#define MAX_FRAGMENTED_PAYLOAD_LENGTH 255
+
+/** @brief What to do with a payload that doesn't fit the max payload of the datarate. */
+enum class PLAN_FALLBACK : uint8_t {
+    FRAGMENT,     /**< Split the payload into fragments, each sent on FRAGMENT_PORT_NUMBER. */
+    SMALLER_PORT, /**< Send the port in PORT_REGISTRY with the most of the port's fields that fits instead. */
+};
+
+/** @brief How a payload will be sent. */
+enum class PAYLOAD_PLAN : uint8_t {
+    SEND,         /**< Fits, send as is. */
+    FRAGMENT,     /**< Doesn't fit, send n_fragments fragments. */
+    SMALLER_PORT, /**< Doesn't fit, send the smaller port instead. */
+    NONE,         /**< Doesn't fit and can't be fragmented or sent with a smaller port. */
+};
+
+/** @brief payloadPlan is the result of planPayload(). */
+struct payloadPlan {
+    PAYLOAD_PLAN plan;
+    portSchema port;            /**< Port to encode with, the smaller port if plan is SMALLER_PORT. */
+    uint8_t payload_length;     /**< Encoded length of the given port (longest for the PRESENCE_BITMAP format). */
+    uint8_t max_payload_length; /**< Max payload of the datarate. */
+    uint8_t n_fragments;        /**< Number of uplinks needed, i.e. 1 unless plan is FRAGMENT. */
+
+    /**
+     * @brief Checks if the port's payload fits the datarate as is.
+     * @return True if it fits, false if not.
+     */
+    inline bool fits(void) const { return plan == PAYLOAD_PLAN::SEND; };
+};
+
+/**
+ * @brief Plans how to send a port's payload at a datarate.
+ * @param port Port to be sent.
+ * @param max_payload_length Max payload of the next uplink, e.g. from getLoRaWANMaxPayloadSize().
+ * @param fallback What to do if the payload doesn't fit.
+ * @return The plan.
+ */
+payloadPlan planPayload(portSchema port, uint8_t max_payload_length, PLAN_FALLBACK fallback);
+
+/**
+ * @brief Get the number of fragments a payload is split into.
+ * @param payload_length Length of the payload.
+ * @param max_payload_length Max payload of the datarate.
+ * @return Number of fragments, or 0 if it needs more than MAX_FRAGMENTS.
+ */
+uint8_t fragmentCount(uint8_t payload_length, uint8_t max_payload_length);
+
+/**
+ * @brief Encodes one fragment of a payload, to be sent on FRAGMENT_PORT_NUMBER.
+ * Every fragment starts with the header; the first also has the port number of the payload, then the payload bytes.
+ * @param payload Payload to be fragmented.
+ * @param payload_length Length of the payload.
+ * @param port_number Port number of the payload.
+ * @param fragment Index of the fragment to encode.
+ * @param max_payload_length Max payload of the datarate.
+ * @param fragment_buffer Buffer for the fragment to be written into, must fit max_payload_length bytes.
+ * @return Length of the fragment, or 0 if there is no such fragment.
+ */
+uint8_t encodeFragment(const uint8_t *payload, uint8_t payload_length, uint8_t port_number, uint8_t fragment,
+                       uint8_t max_payload_length, uint8_t *fragment_buffer);
+
+/**
+ * @brief FragmentReassembler rebuilds a payload from its fragments, received in order.
+ * A missing fragment drops the payload; the next first fragment starts again.
+ */
+class FragmentReassembler {
+  public:
+    /**
+     * @brief Adds a received fragment.
+     * @param buffer Fragment payload, i.e. received on FRAGMENT_PORT_NUMBER.
+     * @param len Length of fragment payload.
+     * @return True if this was the last fragment and the payload is complete, false if not.
+     */
+    bool addFragment(const uint8_t *buffer, uint8_t len);
+
+    /**
+     * @brief Get the port number of the complete payload.
+     * @return Port number.
+     */
+    inline uint8_t getPortNumber(void) const { return port_number; };
+
+    /**
+     * @brief Get the complete payload.
+     * @return Payload buffer, getPayloadLength() bytes long.
+     */
+    inline uint8_t *getPayload(void) { return payload; };
+
+    /**
+     * @brief Get the length of the complete payload.
+     * @return Payload length in bytes.
+     */
+    inline uint8_t getPayloadLength(void) const { return payload_length; };
+
+  private:
+    uint8_t payload[MAX_FRAGMENTED_PAYLOAD_LENGTH] = {};
+    uint8_t payload_length = 0;
+    uint8_t port_number = 0;
+    uint8_t next_fragment = 0; // 0 while waiting for a first fragment
+};
+
+#endif // PAYLOAD_PLANNER_H
@@ -1,176 +1,255 @@
 #include "PortSchema.h"
 
+#include <string.h>
 
-uint8_t portSchema::encodeSensorDataToPayload(sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos) {
-    /* If the data should be included in the payload according to the portSchema, then encode the value.
-     * he order of these if statements is the order the sensor data will be encoded into the payload and should match
-     * the schema.
-     * The buffsize is increased by the amount of data encoded in each step.
-     */
-    uint8_t payload_length = start_pos;
-    if (sendBatteryVoltage) {
-        payload_length = batteryVoltageSchema.encodeData(
-            sensor_data->battery_mv.value, sensor_data->battery_mv.is_valid, payload_buffer, payload_length);
+/**
+ * @brief Encodes each value of a sensor field into the payload.
+ * @param field Sensor field to encode.
+ * @param sensor_data Sensor data holding the field.
+ * @param payload_buffer Payload buffer for data to be written into.
+ * @param buf_pos Start encoding from this byte.
+ * @return New total length of data encoded to payload_buffer - includes buf_pos.
+ */
+static uint8_t encodeField(const sensorField *field, sensorData *sensor_data, uint8_t *payload_buffer, uint8_t buf_pos) {
+    uint8_t *data = (uint8_t *)sensor_data;
+    bool valid = *(bool *)(data + field->valid_offset);
+
+    for (uint8_t v = 0; v < field->schema->n_values; v++) {
+        uint8_t *value = data + field->value_offsets[v];
+        if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+            buf_pos = field->schema->encodeData(*(float *)value, valid, payload_buffer, buf_pos);
+        } else {
+            buf_pos = field->schema->encodeData(*(uint32_t *)value, valid, payload_buffer, buf_pos);
+        }
     }
-    if (sendTemperature) {
-        payload_length = temperatureSchema.encodeData(sensor_data->temperature.value, sensor_data->temperature.is_valid,
-                                                      payload_buffer, payload_length);
+    return buf_pos;
+}
+
+/**
+ * @brief Decodes each value of a sensor field from the buffer.
+ * @param field Sensor field to decode.
+ * @param sensor_data Sensor data that the field is decoded into.
+ * @param buffer Buffer that data will be decoded from.
+ * @param buf_pos Start decoding from this byte.
+ * @return New total length of data decoded from buffer - includes buf_pos.
+ */
+static uint8_t decodeField(const sensorField *field, sensorData *sensor_data, uint8_t *buffer, uint8_t buf_pos) {
+    uint8_t *data = (uint8_t *)sensor_data;
+    bool *valid = (bool *)(data + field->valid_offset);
+
+    for (uint8_t v = 0; v < field->schema->n_values; v++) {
+        uint8_t *value = data + field->value_offsets[v];
+        if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+            buf_pos = field->schema->decodeData((float *)value, valid, buffer, buf_pos);
+        } else {
+            buf_pos = field->schema->decodeData((uint32_t *)value, valid, buffer, buf_pos);
+        }
     }
-    if (sendRelativeHumidity) {
-        payload_length = relativeHumiditySchema.encodeData(sensor_data->humidity.value, sensor_data->humidity.is_valid,
-                                                           payload_buffer, payload_length);
+    return buf_pos;
+}
+
+/**
+ * @brief Bit encodes each value of a sensor field into the payload, for the BIT_PACKED payload format.
+ * @param field Sensor field to encode.
+ * @param sensor_data Sensor data holding the field.
+ * @param payload_buffer Payload buffer for data to be written into.
+ * @param bit_pos Start encoding from this bit.
+ * @return New total length (in bits) of data encoded to payload_buffer - includes bit_pos.
+ */
+static uint16_t encodeFieldBits(const sensorField *field, sensorData *sensor_data, uint8_t *payload_buffer, uint16_t bit_pos) {
+    uint8_t *data = (uint8_t *)sensor_data;
+    bool valid = *(bool *)(data + field->valid_offset);
+
+    for (uint8_t v = 0; v < field->schema->n_values; v++) {
+        uint8_t *value = data + field->value_offsets[v];
+        if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+            bit_pos = field->schema->encodeBits(*(float *)value, valid, payload_buffer, bit_pos);
+        } else {
+            bit_pos = field->schema->encodeBits(*(uint32_t *)value, valid, payload_buffer, bit_pos);
+        }
     }
-    if (sendAirPressure) {
-        payload_length = airPressureSchema.encodeData(sensor_data->pressure.value, sensor_data->pressure.is_valid,
-                                                      payload_buffer, payload_length);
+    return bit_pos;
+}
+
+/**
+ * @brief Bit decodes each value of a sensor field from the buffer, for the BIT_PACKED payload format.
+ * @param field Sensor field to decode.
+ * @param sensor_data Sensor data that the field is decoded into.
+ * @param buffer Buffer that data will be decoded from.
+ * @param bit_pos Start decoding from this bit.
+ * @return New total length (in bits) of data decoded from buffer - includes bit_pos.
+ */
+static uint16_t decodeFieldBits(const sensorField *field, sensorData *sensor_data, uint8_t *buffer, uint16_t bit_pos) {
+    uint8_t *data = (uint8_t *)sensor_data;
+    bool *valid = (bool *)(data + field->valid_offset);
+
+    for (uint8_t v = 0; v < field->schema->n_values; v++) {
+        uint8_t *value = data + field->value_offsets[v];
+        if (field->value_type == SENSOR_VALUE_TYPE::FLOAT) {
+            bit_pos = field->schema->decodeBits((float *)value, valid, buffer, bit_pos);
+        } else {
+            bit_pos = field->schema->decodeBits((uint32_t *)value, valid, buffer, bit_pos);
+        }
     }
-    if (sendGasResistance) {
-        payload_length = gasResistanceSchema.encodeData(sensor_data->gas_resist.value, sensor_data->gas_resist.is_valid,
-                                                        payload_buffer, payload_length);
+    return bit_pos;
+}
+
+/**
+ * @brief Checks the validity flag of a sensor field.
+ * @param field Sensor field to check.
+ * @param sensor_data Sensor data holding the field.
+ * @return True if the field's data is valid.
+ */
+static bool fieldIsValid(const sensorField *field, const sensorData *sensor_data) {
+    return *(const bool *)((const uint8_t *)sensor_data + field->valid_offset);
+}
+
+/* Each set bit of the sensor_mask is a sensor field to encode. The bits are visited lowest first, which is the order
+ * the sensor data is encoded into the payload for every payload format.
+ * The payload length is increased by the amount of data encoded in each step.
+ */
+
+/** @brief encodeSensorDataToPayload() for the FIXED payload format. */
+static uint8_t encodeFixed(uint16_t sensor_mask, sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos) {
+    uint8_t payload_length = start_pos;
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        payload_length = encodeField(&SENSOR_FIELDS[__builtin_ctz(fields)], sensor_data, payload_buffer, payload_length);
     }
-    if (sendLocation) {
-        payload_length = locationSchema.encodeData(sensor_data->location.latitude, sensor_data->location.is_valid,
-                                                   payload_buffer, payload_length);
-        payload_length = locationSchema.encodeData(sensor_data->location.longitude, sensor_data->location.is_valid,
-                                                   payload_buffer, payload_length);
+    return payload_length;
+}
+
+/** @brief encodeSensorDataToPayload() for the BIT_PACKED payload format. */
+static uint8_t encodeBitPacked(uint16_t sensor_mask, sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos) {
+    uint16_t bit_pos = start_pos * 8;
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        bit_pos = encodeFieldBits(&SENSOR_FIELDS[__builtin_ctz(fields)], sensor_data, payload_buffer, bit_pos);
     }
-    if (sendCurrentSensor) {
-        payload_length = currentSensorSchema.encodeData(
-            sensor_data->current_A.value, sensor_data->current_A.is_valid, payload_buffer, payload_length);
-        // Added to try send through raw ADC value
-        payload_length = currentSensorSchema.encodeData(
-            sensor_data->current_A.ADCval, sensor_data->current_A.is_valid, payload_buffer, payload_length);
+    // pad the last byte with 0's
+    if ((bit_pos % 8) != 0) {
+        storeBits(payload_buffer, bit_pos, 0, 8 - (bit_pos % 8));
     }
-    return payload_length;
+    return (uint8_t)((bit_pos + 7) / 8);
 }
 
-sensorData portSchema::decodePayloadToSensorData(uint8_t *buffer, uint8_t len, uint8_t start_pos) {
-    sensorData sensor_data = {};
-    uint8_t buff_pos = start_pos;
+/**
+ * @brief encodeSensorDataToPayload() for the PRESENCE_BITMAP payload format.
+ * The bitmap has a bit per field of the sensor_mask, MSB first, set if the field is valid and hence in the payload.
+ */
+static uint8_t encodePresenceBitmap(uint16_t sensor_mask, sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos) {
+    uint8_t *bitmap = &payload_buffer[start_pos];
+    uint8_t payload_length = start_pos + presenceBitmapLength(sensor_mask);
+    memset(bitmap, 0, presenceBitmapLength(sensor_mask));
 
-    if (sendBatteryVoltage && (buff_pos < len)) {
-        buff_pos = batteryVoltageSchema.decodeData(&sensor_data.battery_mv.value, &sensor_data.battery_mv.is_valid, buffer, buff_pos);
+    uint8_t bit = 0;
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1), bit++) {
+        const sensorField *field = &SENSOR_FIELDS[__builtin_ctz(fields)];
+        if (fieldIsValid(field, sensor_data)) {
+            bitmap[bit / 8] |= (uint8_t)(0x80 >> (bit % 8));
+            payload_length = encodeField(field, sensor_data, payload_buffer, payload_length);
+        }
     }
-    if (sendTemperature && (buff_pos < len)) {
-        buff_pos = temperatureSchema.decodeData(&sensor_data.temperature.value, &sensor_data.temperature.is_valid, buffer, buff_pos);
+    return payload_length;
+}
+
+uint8_t portSchema::encodeSensorDataToPayload(sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos) const {
+    switch (payload_format) {
+        case PAYLOAD_FORMAT::BIT_PACKED:
+            return encodeBitPacked(sensor_mask, sensor_data, payload_buffer, start_pos);
+        case PAYLOAD_FORMAT::PRESENCE_BITMAP:
+            return encodePresenceBitmap(sensor_mask, sensor_data, payload_buffer, start_pos);
+        default:
+            return encodeFixed(sensor_mask, sensor_data, payload_buffer, start_pos);
     }
-    if (sendRelativeHumidity && (buff_pos < len)) {
-        buff_pos = relativeHumiditySchema.decodeData(&sensor_data.humidity.value, &sensor_data.humidity.is_valid, buffer, buff_pos);
+}
+
+/** @brief decodePayloadToSensorData() for the FIXED payload format. */
+static void decodeFixed(uint16_t sensor_mask, sensorData *sensor_data, uint8_t *buffer, uint8_t len, uint8_t start_pos) {
+    uint8_t buff_pos = start_pos;
+    for (uint16_t fields = sensor_mask; (fields != 0) && (buff_pos < len); fields &= (fields - 1)) {
+        buff_pos = decodeField(&SENSOR_FIELDS[__builtin_ctz(fields)], sensor_data, buffer, buff_pos);
     }
-    if (sendAirPressure && (buff_pos < len)) {
-        buff_pos = airPressureSchema.decodeData(&sensor_data.pressure.value, &sensor_data.pressure.is_valid, buffer, buff_pos);
+}
+
+/** @brief decodePayloadToSensorData() for the BIT_PACKED payload format. */
+static void decodeBitPacked(uint16_t sensor_mask, sensorData *sensor_data, uint8_t *buffer, uint8_t len, uint8_t start_pos) {
+    uint16_t bit_pos = start_pos * 8;
+    for (uint16_t fields = sensor_mask; fields != 0; fields &= (fields - 1)) {
+        const sensorField *field = &SENSOR_FIELDS[__builtin_ctz(fields)];
+        // stop if the payload is too short for the whole field
+        if ((bit_pos + field->schema->n_bits * field->schema->n_values) > (len * 8)) {
+            break;
+        }
+        bit_pos = decodeFieldBits(field, sensor_data, buffer, bit_pos);
     }
-    if (sendGasResistance && (buff_pos < len)) {
-        buff_pos = gasResistanceSchema.decodeData(&sensor_data.gas_resist.value, &sensor_data.gas_resist.is_valid, buffer, buff_pos);
+}
+
+/**
+ * @brief decodePayloadToSensorData() for the PRESENCE_BITMAP payload format.
+ * Only the fields set in the bitmap are decoded, the rest are left invalid.
+ */
+static void decodePresenceBitmap(uint16_t sensor_mask, sensorData *sensor_data, uint8_t *buffer, uint8_t len, uint8_t start_pos) {
+    uint8_t *bitmap = &buffer[start_pos];
+    uint8_t buff_pos = start_pos + presenceBitmapLength(sensor_mask);
+    if (buff_pos > len) {
+        return; // too short for the bitmap
     }
-    if (sendLocation && (buff_pos < len)) {
-        buff_pos = locationSchema.decodeData(&sensor_data.location.latitude, &sensor_data.location.is_valid, buffer, buff_pos);
-        buff_pos = locationSchema.decodeData(&sensor_data.location.longitude, &sensor_data.location.is_valid, buffer, buff_pos);
+
+    uint8_t bit = 0;
+    for (uint16_t fields = sensor_mask; (fields != 0) && (buff_pos < len); fields &= (fields - 1), bit++) {
+        if (bitmap[bit / 8] & (0x80 >> (bit % 8))) {
+            buff_pos = decodeField(&SENSOR_FIELDS[__builtin_ctz(fields)], sensor_data, buffer, buff_pos);
+        }
     }
-    if (sendCurrentSensor && (buff_pos < len)) {
-        buff_pos = currentSensorSchema.decodeData(&sensor_data.current_A.value, &sensor_data.current_A.is_valid, buffer, buff_pos);
-        // added to send through ADC value
-        buff_pos = currentSensorSchema.decodeData(&sensor_data.current_A.ADCval, &sensor_data.current_A.is_valid, buffer, buff_pos);
+}
+
+sensorData portSchema::decodePayloadToSensorData(uint8_t *buffer, uint8_t len, uint8_t start_pos) const {
+    sensorData sensor_data = {};
+
+    switch (payload_format) {
+        case PAYLOAD_FORMAT::BIT_PACKED:
+            decodeBitPacked(sensor_mask, &sensor_data, buffer, len, start_pos);
+            break;
+        case PAYLOAD_FORMAT::PRESENCE_BITMAP:
+            decodePresenceBitmap(sensor_mask, &sensor_data, buffer, len, start_pos);
+            break;
+        default:
+            decodeFixed(sensor_mask, &sensor_data, buffer, len, start_pos);
+            break;
     }
 
     return sensor_data;
 }
 
-bool portSchema::operator==(const portSchema &port2) {
-    // clang-format off
-    return ((port_number          == port2.port_number         ) &&
-            (sendBatteryVoltage   == port2.sendBatteryVoltage  ) &&
-            (sendTemperature      == port2.sendTemperature     ) &&
-            (sendRelativeHumidity == port2.sendRelativeHumidity) &&
-            (sendAirPressure      == port2.sendAirPressure     ) &&
-            (sendGasResistance    == port2.sendGasResistance   ) &&
-            (sendLocation         == port2.sendLocation        ) &&
-            (sendCurrentSensor    == port2.sendCurrentSensor   ));
-    // clang-format on
+/**
+ * @brief Finds the given port number in PORT_REGISTRY at compile time.
+ * @param port_number Port number to look for.
+ * @param i Registry index to start looking from.
+ * @return The port, or PORTERROR if it isn't in the registry.
+ */
+static constexpr portSchema registeredPort(uint8_t port_number, size_t i = 0) {
+    return (i >= sizeof(PORT_REGISTRY) / sizeof(PORT_REGISTRY[0])) ? PORTERROR
+           : (PORT_REGISTRY[i].port_number == port_number)         ? PORT_REGISTRY[i]
+                                                                    : registeredPort(port_number, i + 1);
 }
 
-portSchema &portSchema::operator+(const portSchema &port2) const {
-    portSchema combined_port = PORTERROR;
-    // clang-format off
-    combined_port.port_number = 0;
-    combined_port.sendBatteryVoltage   = (this->sendBatteryVoltage   || port2.sendBatteryVoltage  );
-    combined_port.sendTemperature      = (this->sendTemperature      || port2.sendTemperature     );
-    combined_port.sendRelativeHumidity = (this->sendRelativeHumidity || port2.sendRelativeHumidity);
-    combined_port.sendAirPressure      = (this->sendAirPressure      || port2.sendAirPressure     );
-    combined_port.sendGasResistance    = (this->sendGasResistance    || port2.sendGasResistance   );
-    combined_port.sendLocation         = (this->sendLocation         || port2.sendLocation        );
-    combined_port.sendCurrentSensor    = (this->sendCurrentSensor    || port2.sendCurrentSensor   );
-    // clang-format on
-    return combined_port;
-}
+/** @brief Compile time list of port numbers used to fill the port lookup table. */
+template <uint8_t... port_numbers> struct portNumberList {
+    static constexpr portSchema ports[sizeof...(port_numbers)] = { registeredPort(port_numbers)... };
+};
+template <uint8_t... port_numbers> constexpr portSchema portNumberList<port_numbers...>::ports[sizeof...(port_numbers)];
+
+/** @brief Makes portNumberList<0, 1, ..., n - 1>. */
+template <uint8_t n, uint8_t... port_numbers> struct makePortNumberList : makePortNumberList<n - 1, n - 1, port_numbers...> {};
+template <uint8_t... port_numbers> struct makePortNumberList<0, port_numbers...> {
+    typedef portNumberList<port_numbers...> type;
+};
+
+/** @brief Every app port, indexed by port number. PORTERROR for undefined ports. */
+typedef makePortNumberList<MAX_APP_PORT_NUMBER + 1>::type portLookupTable;
 
 portSchema getPort(uint8_t port_number) {
-    switch (port_number) {
-        case 1: {
-            return PORT1;
-        }
-        case 2: {
-            return PORT2;
-        }
-        case 3: {
-            return PORT3;
-        }
-        case 4: {
-            return PORT4;
-        }
-        case 5: {
-            return PORT5;
-        }
-        case 6: {
-            return PORT6;
-        }
-        case 7: {
-            return PORT7;
-        }
-        case 8: {
-            return PORT8;
-        }
-        case 9: {
-            return PORT9;
-        }
-        case 10: {
-            return PORT10;
-        }
-        case 11: {
-            return PORT11;
-        }
-        case 50: {
-            return PORT50;
-        }
-        case 51: {
-            return PORT51;
-        }
-        case 52: {
-            return PORT52;
-        }
-        case 53: {
-            return PORT53;
-        }
-        case 54: {
-            return PORT54;
-        }
-        case 55: {
-            return PORT55;
-        }
-        case 56: {
-            return PORT56;
-        }
-        case 57: {
-            return PORT57;
-        }
-        case 58: {
-            return PORT58;
-        }
-        case 59: {
-            return PORT59;
-        }
-        default: {
-            return PORTERROR;
-        }
+    if (port_number > MAX_APP_PORT_NUMBER) {
+        return PORTERROR;
     }
-}
\ No newline at end of file
+    return portLookupTable::ports[port_number];
+}
@@ -13,43 +13,183 @@
  * @copyright (c) 2021 Kalina Knight - MIT License
  */
 
+#include <stddef.h>
+
 #include "SensorPortSchema.h" /**< Go here for the individual sensor schema definitions. */
 
+/**
+ * @brief The sensor data fields that a port can include in its payload.
+ * The value of each field is its bit in a portSchema sensor_mask, and also sets the order the fields are encoded into
+ * the payload: lowest bit first.
+ */
+enum class SENSOR_FIELD : uint8_t {
+    BATTERY_VOLTAGE = 0,
+    TEMPERATURE,
+    RELATIVE_HUMIDITY,
+    AIR_PRESSURE,
+    GAS_RESISTANCE,
+    LOCATION,
+    CURRENT_SENSOR,
+    AC_CURRENT,
+    HARMONICS,
+    THD,
+    /* An example of a new sensor:
+    NEW_SENSOR,
+    */
+    COUNT /**< Number of sensor fields - must stay last. */
+};
+
+/**
+ * @brief Get the bit of the given sensor field in a portSchema sensor_mask.
+ * @param field Sensor field.
+ * @return The sensor mask with only the given field set.
+ */
+constexpr uint16_t fieldMask(SENSOR_FIELD field) {
+    return (uint16_t)(1U << (uint8_t)field);
+}
+
+// Sensor mask bits for defining ports, e.g. SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE
+static constexpr uint16_t SEND_BATTERY_VOLTAGE = fieldMask(SENSOR_FIELD::BATTERY_VOLTAGE);
+static constexpr uint16_t SEND_TEMPERATURE = fieldMask(SENSOR_FIELD::TEMPERATURE);
+static constexpr uint16_t SEND_RELATIVE_HUMIDITY = fieldMask(SENSOR_FIELD::RELATIVE_HUMIDITY);
+static constexpr uint16_t SEND_AIR_PRESSURE = fieldMask(SENSOR_FIELD::AIR_PRESSURE);
+static constexpr uint16_t SEND_GAS_RESISTANCE = fieldMask(SENSOR_FIELD::GAS_RESISTANCE);
+static constexpr uint16_t SEND_LOCATION = fieldMask(SENSOR_FIELD::LOCATION);
+static constexpr uint16_t SEND_CURRENT_SENSOR = fieldMask(SENSOR_FIELD::CURRENT_SENSOR);
+static constexpr uint16_t SEND_AC_CURRENT = fieldMask(SENSOR_FIELD::AC_CURRENT);
+static constexpr uint16_t SEND_HARMONICS = fieldMask(SENSOR_FIELD::HARMONICS);
+static constexpr uint16_t SEND_THD = fieldMask(SENSOR_FIELD::THD);
+
+/** @brief Type of the value(s) stored in sensorData for a sensor field. */
+enum class SENSOR_VALUE_TYPE : uint8_t {
+    FLOAT,
+    UINT32,
+};
+
+#define MAX_FIELD_VALUES 4 /**< Max number of values a sensor field can have, e.g. latitude & longitude. */
+
+/**
+ * @brief sensorField describes where a sensor field lives in sensorData and which sensorPortSchema encodes it.
+ * This is what lets portSchema encode and decode any combination of fields with one loop.
+ */
+struct sensorField {
+    const sensorPortSchema *schema;       /**< Schema used to encode/decode each value. */
+    SENSOR_VALUE_TYPE value_type;         /**< Type of the value(s) in sensorData. */
+    uint8_t valid_offset;                 /**< Offset of the is_valid flag in sensorData. */
+    uint8_t value_offsets[MAX_FIELD_VALUES]; /**< Offset of each value in sensorData - only schema->n_values are used. */
+};
+
+/**
+ * @brief Sensor field table, one row per SENSOR_FIELD and in the same order.
+ * To add a new sensor add its row here (plus its SENSOR_FIELD, sensorData member and sensorPortSchema).
+ */
+// clang-format off
+static constexpr sensorField SENSOR_FIELDS[] = {
+    // schema,               value type,                value valid flag,                          value(s)
+    { &batteryVoltageSchema,   SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, battery_mv.is_valid),  { offsetof(sensorData, battery_mv.value) } },
+    { &temperatureSchema,      SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, temperature.is_valid), { offsetof(sensorData, temperature.value) } },
+    { &relativeHumiditySchema, SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, humidity.is_valid),    { offsetof(sensorData, humidity.value) } },
+    { &airPressureSchema,      SENSOR_VALUE_TYPE::UINT32, offsetof(sensorData, pressure.is_valid),    { offsetof(sensorData, pressure.value) } },
+    { &gasResistanceSchema,    SENSOR_VALUE_TYPE::UINT32, offsetof(sensorData, gas_resist.is_valid),  { offsetof(sensorData, gas_resist.value) } },
+    { &locationSchema,         SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, location.is_valid),    { offsetof(sensorData, location.latitude),
+                                                                                                        offsetof(sensorData, location.longitude) } },
+    { &currentSensorSchema,    SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, current_A.is_valid),   { offsetof(sensorData, current_A.value),
+                                                                                                        offsetof(sensorData, current_A.ADCval) } },
+    { &acCurrentSchema,        SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, ac_current.is_valid),  { offsetof(sensorData, ac_current.rms),
+                                                                                                        offsetof(sensorData, ac_current.peak) } },
+    { &harmonicsSchema,        SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, harmonics.is_valid),   { offsetof(sensorData, harmonics.fundamental),
+                                                                                                        offsetof(sensorData, harmonics.h3),
+                                                                                                        offsetof(sensorData, harmonics.h5),
+                                                                                                        offsetof(sensorData, harmonics.h7) } },
+    { &thdSchema,              SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, thd.is_valid),         { offsetof(sensorData, thd.value) } },
+    /* An example of a new sensor:
+    { &newSensorSchema,        SENSOR_VALUE_TYPE::FLOAT,  offsetof(sensorData, new_sensor.is_valid),  { offsetof(sensorData, new_sensor.value) } },
+    */
+};
+// clang-format on
+
+static_assert(sizeof(SENSOR_FIELDS) / sizeof(SENSOR_FIELDS[0]) == (size_t)SENSOR_FIELD::COUNT,
+              "SENSOR_FIELDS needs exactly one row per SENSOR_FIELD.");
+
+/** @brief How the sensor fields of a port are laid out in the payload. */
+enum class PAYLOAD_FORMAT : uint8_t {
+    FIXED = 0,       /**< Each value is n_bytes/n_values whole bytes (default). */
+    BIT_PACKED,      /**< Each value is n_bits, packed across byte boundaries. */
+    PRESENCE_BITMAP, /**< A leading bitmap of the valid fields, then only the valid fields - laid out as FIXED. */
+};
+
+/**
+ * @brief Get the length of the leading bitmap of the PRESENCE_BITMAP payload format, one bit per sensor field.
+ * @param sensor_mask Bitmask of the sensor fields, see SENSOR_FIELD.
+ * @return Bitmap length in bytes.
+ */
+constexpr uint8_t presenceBitmapLength(uint16_t sensor_mask) {
+    return (uint8_t)((__builtin_popcount(sensor_mask) + 7) / 8);
+}
+
+/**
+ * @brief Get the number of bits a sensor mask takes up in the payload.
+ * @param sensor_mask Bitmask of the sensor fields, see SENSOR_FIELD.
+ * @param payload_format Payload format the fields are encoded with.
+ * @param field Field to start counting from.
+ * @return Total bits of the sensor fields.
+ */
+constexpr uint16_t sensorMaskBits(uint16_t sensor_mask, PAYLOAD_FORMAT payload_format, uint8_t field = 0) {
+    return (field >= (uint8_t)SENSOR_FIELD::COUNT) ? 0
+           : (((sensor_mask >> field) & 1) == 0)   ? sensorMaskBits(sensor_mask, payload_format, field + 1)
+           : ((payload_format == PAYLOAD_FORMAT::BIT_PACKED)
+                  ? SENSOR_FIELDS[field].schema->n_bits * SENSOR_FIELDS[field].schema->n_values
+                  : SENSOR_FIELDS[field].schema->n_bytes * 8) +
+                 sensorMaskBits(sensor_mask, payload_format, field + 1);
+}
+
 /** @brief portSchema describes which sensor data to include in each port and hence the payload. */
 struct portSchema {
     uint8_t port_number;
+    uint16_t sensor_mask;          /**< Bitmask of the sensor fields included in this port, see SENSOR_FIELD. */
+    PAYLOAD_FORMAT payload_format; /**< Layout of the payload, FIXED for the original layout. */
 
-    /**< Flags for if the sensors data is included in this port. */
-    bool sendBatteryVoltage;
-    bool sendTemperature;
-    bool sendRelativeHumidity;
-    bool sendAirPressure;
-    bool sendGasResistance;
-    bool sendLocation;
-    bool sendCurrentSensor;
-    /* An example of a new sensor:
-    bool sendNewSensor;
-    */
+    /**
+     * @brief Checks if the given sensor data is included in this port.
+     * @param field Sensor field to check.
+     * @return True if the sensor data is sent with this port, false if not.
+     */
+    constexpr bool sends(SENSOR_FIELD field) const {
+        return (sensor_mask & fieldMask(field)) != 0;
+    }
+
+    /**
+     * @brief Get the length of this port's payload.
+     * For the PRESENCE_BITMAP payload format this is the longest it can be, i.e. with every field valid.
+     * @return Payload length in bytes.
+     */
+    constexpr uint8_t payloadLength(void) const {
+        return (uint8_t)((sensorMaskBits(sensor_mask, payload_format) + 7) / 8) +
+               ((payload_format == PAYLOAD_FORMAT::PRESENCE_BITMAP) ? presenceBitmapLength(sensor_mask) : 0);
+    }
 
     /**
      * @brief Encodes the given sensor data into the payload according to the port's schema.
-     * Calls sensorPortSchema::encodeData for each sensor.
+     * Calls sensorPortSchema::encodeData (or encodeBits for the BIT_PACKED payload format) for each value of each sensor
+     * field in the sensor_mask. A BIT_PACKED payload is padded with 0's to a whole byte, and a PRESENCE_BITMAP payload
+     * leaves out the invalid fields.
      * @param sensor_data Sensor data to be encoded.
      * @param payload_buffer Payload buffer for data to be written into.
      * @param start_pos Start encoding data at this byte. Defaults to 0.
      * @return Total length of data encoded to payload_buffer.
      */
-    uint8_t encodeSensorDataToPayload(sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos = 0);
+    uint8_t encodeSensorDataToPayload(sensorData *sensor_data, uint8_t *payload_buffer, uint8_t start_pos = 0) const;
 
     /**
      * @brief Decodes the given payload into the sensor data according to the port's schema.
-     * Calls sensorPortSchema::decodeData for each sensor.
+     * Calls sensorPortSchema::decodeData (or decodeBits for the BIT_PACKED payload format) for each value of each sensor
+     * field in the sensor_mask. Fields left out of a PRESENCE_BITMAP payload are decoded as invalid.
      * @param buffer Payload buffer to be decoded.
      * @param len Length of payload buffer.
      * @param start_pos Start decoding data at this byte. Defaults to 0.
      * @return Decoded sensor data.
      */
-    sensorData decodePayloadToSensorData(uint8_t *buffer, uint8_t len, uint8_t start_pos = 0);
+    sensorData decodePayloadToSensorData(uint8_t *buffer, uint8_t len, uint8_t start_pos = 0) const;
 
     /**
      * @brief Compares for full equivalence between two port objects.
@@ -57,282 +197,202 @@ struct portSchema {
      * @param port2 Second port that this port is compared to.
      * @return True if they're equivalent, false if not.
      */
-    bool operator==(const portSchema &port2);
+    constexpr bool operator==(const portSchema &port2) const {
+        return (port_number == port2.port_number) && (sensor_mask == port2.sensor_mask) &&
+               (payload_format == port2.payload_format);
+    }
 
     /**
      * @brief Combines two ports into separate port.
-     * The port number is set to 0, and the send sensor flags are ||'ed.
+     * The port number is set to 0, the sensor masks are OR'ed and the payload format of this port is kept.
      * Useful for sensor initiatlisation if using the port definition for this purpose.
      *
      * @param port2 Second port that this port is combined with.
      * @return Another port schema object that combines the given ports.
      */
-    portSchema &operator+(const portSchema &port2) const;
+    constexpr portSchema operator+(const portSchema &port2) const {
+        return portSchema{ 0, (uint16_t)(sensor_mask | port2.sensor_mask), payload_format };
+    }
 };
 
 /**
  * @brief Get the Port object for the given port number.
+ * A constant time lookup into a table built at compile time from PORT_REGISTRY.
  * @param port_number
- * @return Returns the portSchema.
+ * @return Returns the portSchema, or PORTERROR if the port number isn't defined.
  */
 portSchema getPort(uint8_t port_number);
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/** @brief The C++ type of a SENSOR_VALUE_TYPE. */
+template <SENSOR_VALUE_TYPE value_type> struct sensorValue;
+template <> struct sensorValue<SENSOR_VALUE_TYPE::FLOAT> { typedef float type; };
+template <> struct sensorValue<SENSOR_VALUE_TYPE::UINT32> { typedef uint32_t type; };
 
-// SCHEMA DEFINITIONS: See readme for definitions in tabular format.
-
-const portSchema PORTERROR = {
-    __UINT8_MAX__, // port_number
-    false,         // sendBatteryVoltage
-    false,         // sendTemperature
-    false,         // sendRelativeHumidity
-    false,         // sendAirPressure
-    false,         // sendGasResistance
-    false,          // sendLocation
-    false          // sendCurrentSensor
-};
-
-const portSchema PORT1 = {
-    1,     // port_number
-    true,  // sendBatteryVoltage
-    false, // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
+/**
+ * @brief Compile time encoding/decoding of the values of a sensor field, using the FieldCodec of its schema.
+ * Each value is encoded in turn by recursing on V until all of the schema's n_values are done.
+ * @tparam F Index of the sensor field in SENSOR_FIELDS.
+ * @tparam V Index of the value of the sensor field.
+ */
+template <uint8_t F, uint8_t V = 0, bool done = (V >= SENSOR_FIELDS[F].schema->n_values)> struct sensorFieldCodec {
+    typedef FieldCodec<SENSOR_FIELDS[F].schema->n_bytes, SENSOR_FIELDS[F].schema->n_values,
+                       SENSOR_FIELDS[F].schema->scale_num, SENSOR_FIELDS[F].schema->scale_den,
+                       SENSOR_FIELDS[F].schema->is_signed>
+        codec;
+    typedef typename sensorValue<SENSOR_FIELDS[F].value_type>::type value_type;
+
+    static inline uint8_t *encode(const sensorData *sensor_data, bool valid, uint8_t *buffer) {
+        const uint8_t *data = (const uint8_t *)sensor_data;
+        buffer = codec::encode(*(const value_type *)(data + SENSOR_FIELDS[F].value_offsets[V]), valid, buffer);
+        return sensorFieldCodec<F, V + 1>::encode(sensor_data, valid, buffer);
+    }
+
+    static inline const uint8_t *decode(sensorData *sensor_data, bool *valid, const uint8_t *buffer) {
+        uint8_t *data = (uint8_t *)sensor_data;
+        buffer = codec::decode((value_type *)(data + SENSOR_FIELDS[F].value_offsets[V]), valid, buffer);
+        return sensorFieldCodec<F, V + 1>::decode(sensor_data, valid, buffer);
+    }
 };
 
-const portSchema PORT2 = {
-    2,     // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
+template <uint8_t F, uint8_t V> struct sensorFieldCodec<F, V, true> {
+    static inline uint8_t *encode(const sensorData *sensor_data, bool valid, uint8_t *buffer) {
+        (void)sensor_data;
+        (void)valid;
+        return buffer;
+    }
+
+    static inline const uint8_t *decode(sensorData *sensor_data, bool *valid, const uint8_t *buffer) {
+        (void)sensor_data;
+        (void)valid;
+        return buffer;
+    }
 };
 
-const portSchema PORT3 = {
-    3,     // port_number
-    true,  // sendBatteryVoltage
-    true,  // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
+/**
+ * @brief Get the lowest sensor field in a sensor mask.
+ * @param sensor_mask Sensor mask, must not be 0.
+ * @param field Field to start looking from.
+ * @return Index of the lowest set bit.
+ */
+constexpr uint8_t lowestSensorField(uint16_t sensor_mask, uint8_t field = 0) {
+    return (sensor_mask & (1U << field)) ? field : lowestSensorField(sensor_mask, field + 1);
+}
 
-const portSchema PORT4 = {
-    4,     // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
+/**
+ * @brief PortCodec is a portSchema with its sensor mask known at compile time, for the FIXED payload format.
+ * Encoding & decoding is unrolled into straight-line code for each field, with no loops or branches on the schema.
+ * e.g. PortCodec<PORT59.sensor_mask>::encodeSensorDataToPayload(&sensor_data, payload_buffer);
+ * @tparam sensor_mask Bitmask of the sensor fields included in the port, see SENSOR_FIELD.
+ */
+template <uint16_t sensor_mask> struct PortCodec {
+    static constexpr uint8_t FIELD = lowestSensorField(sensor_mask); /**< Field encoded first. */
+    typedef PortCodec<sensor_mask & (sensor_mask - 1)> remaining_fields;
 
-const portSchema PORT5 = {
-    5,     // port_number
-    true,  // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
+    static constexpr uint8_t PAYLOAD_LENGTH = SENSOR_FIELDS[FIELD].schema->n_bytes + remaining_fields::PAYLOAD_LENGTH;
 
-const portSchema PORT6 = {
-    6,     // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    true,  // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
-const portSchema PORT7 = {
-    7,     // port_number
-    true,  // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    true,  // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
+    static inline uint8_t *encodeFields(const sensorData *sensor_data, uint8_t *buffer) {
+        bool valid = *(const bool *)((const uint8_t *)sensor_data + SENSOR_FIELDS[FIELD].valid_offset);
+        buffer = sensorFieldCodec<FIELD>::encode(sensor_data, valid, buffer);
+        return remaining_fields::encodeFields(sensor_data, buffer);
+    }
 
-const portSchema PORT8 = {
-    8,     // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    true,  // sendAirPressure
-    true,  // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
+    static inline const uint8_t *decodeFields(sensorData *sensor_data, const uint8_t *buffer) {
+        bool *valid = (bool *)((uint8_t *)sensor_data + SENSOR_FIELDS[FIELD].valid_offset);
+        buffer = sensorFieldCodec<FIELD>::decode(sensor_data, valid, buffer);
+        return remaining_fields::decodeFields(sensor_data, buffer);
+    }
 
-const portSchema PORT9 = {
-    9,    // port_number
-    true, // sendBatteryVoltage
-    true, // sendTemperature
-    true, // sendRelativeHumidity
-    true, // sendAirPressure
-    true, // sendGasResistance
-    false, // sendLocation
-    false  // sendCurrentSensor
-};
-
-const portSchema PORT10 = {
-    10,     // port_number
-    false,  // sendBatteryVoltage
-    false, // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    true  // sendCurrentSensor
-};
+    /**
+     * @brief Encodes the given sensor data into the payload, the same as portSchema::encodeSensorDataToPayload().
+     * @param sensor_data Sensor data to be encoded.
+     * @param payload_buffer Payload buffer for data to be written into, must fit PAYLOAD_LENGTH bytes.
+     * @return Total length of data encoded to payload_buffer, always PAYLOAD_LENGTH.
+     */
+    static inline uint8_t encodeSensorDataToPayload(const sensorData *sensor_data, uint8_t *payload_buffer) {
+        return (uint8_t)(encodeFields(sensor_data, payload_buffer) - payload_buffer);
+    }
 
-const portSchema PORT11 = {
-    11,     // port_number
-    true,  // sendBatteryVoltage
-    false, // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false, // sendLocation
-    true  // sendCurrentSensor
+    /**
+     * @brief Decodes the given payload into the sensor data, the same as portSchema::decodePayloadToSensorData().
+     * @param buffer Payload buffer to be decoded, must be PAYLOAD_LENGTH bytes long.
+     * @return Decoded sensor data.
+     */
+    static inline sensorData decodePayloadToSensorData(const uint8_t *buffer) {
+        sensorData sensor_data = {};
+        decodeFields(&sensor_data, buffer);
+        return sensor_data;
+    }
 };
 
-const portSchema PORT50 = {
-    50,    // port_number
-    false, // sendBatteryVoltage
-    false, // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
+template <> struct PortCodec<0> {
+    static constexpr uint8_t PAYLOAD_LENGTH = 0;
 
-const portSchema PORT51 = {
-    51,    // port_number
-    true,  // sendBatteryVoltage
-    false, // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    true, // sendLocation
-    false  // sendCurrentSensor
-};
+    static inline uint8_t *encodeFields(const sensorData *sensor_data, uint8_t *buffer) {
+        (void)sensor_data;
+        return buffer;
+    }
 
-const portSchema PORT52 = {
-    52,    // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
+    static inline const uint8_t *decodeFields(sensorData *sensor_data, const uint8_t *buffer) {
+        (void)sensor_data;
+        return buffer;
+    }
 };
 
-const portSchema PORT53 = {
-    53,    // port_number
-    true,  // sendBatteryVoltage
-    true,  // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
+template <uint16_t sensor_mask> constexpr uint8_t PortCodec<sensor_mask>::FIELD;
+template <uint16_t sensor_mask> constexpr uint8_t PortCodec<sensor_mask>::PAYLOAD_LENGTH;
 
-const portSchema PORT54 = {
-    54,    // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const portSchema PORT55 = {
-    55,    // port_number
-    true,  // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
+// SCHEMA DEFINITIONS: See readme for definitions in tabular format.
 
-const portSchema PORT56 = {
-    56,    // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    true,  // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
-const portSchema PORT57 = {
-    57,    // port_number
-    true,  // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    true,  // sendAirPressure
-    false, // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
+// clang-format off
+static constexpr portSchema PORTERROR = { __UINT8_MAX__, 0, PAYLOAD_FORMAT::FIXED };
+
+static constexpr portSchema PORT1  = { 1,  SEND_BATTERY_VOLTAGE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT2  = { 2,                        SEND_TEMPERATURE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT3  = { 3,  SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT4  = { 4,                        SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT5  = { 5,  SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT6  = { 6,                        SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT7  = { 7,  SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT8  = { 8,                        SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_GAS_RESISTANCE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT9  = { 9,  SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_GAS_RESISTANCE, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT10 = { 10,                       SEND_CURRENT_SENSOR, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT11 = { 11, SEND_BATTERY_VOLTAGE | SEND_CURRENT_SENSOR, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT12 = { 12,                       SEND_CURRENT_SENSOR | SEND_AC_CURRENT, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT13 = { 13, SEND_BATTERY_VOLTAGE | SEND_CURRENT_SENSOR | SEND_AC_CURRENT, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT14 = { 14,                       SEND_CURRENT_SENSOR | SEND_AC_CURRENT | SEND_HARMONICS | SEND_THD, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT15 = { 15, SEND_BATTERY_VOLTAGE | SEND_CURRENT_SENSOR | SEND_AC_CURRENT | SEND_HARMONICS | SEND_THD, PAYLOAD_FORMAT::FIXED };
+
+static constexpr portSchema PORT50 = { 50,                       SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT51 = { 51, SEND_BATTERY_VOLTAGE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT52 = { 52,                       SEND_TEMPERATURE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT53 = { 53, SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT54 = { 54,                       SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT55 = { 55, SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT56 = { 56,                       SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT57 = { 57, SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT58 = { 58,                       SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_GAS_RESISTANCE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
+static constexpr portSchema PORT59 = { 59, SEND_BATTERY_VOLTAGE | SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_GAS_RESISTANCE | SEND_LOCATION, PAYLOAD_FORMAT::FIXED };
 
-const portSchema PORT58 = {
-    58,    // port_number
-    false, // sendBatteryVoltage
-    true,  // sendTemperature
-    true,  // sendRelativeHumidity
-    true,  // sendAirPressure
-    true,  // sendGasResistance
-    true,   // sendLocation
-    false  // sendCurrentSensor
-};
+/* An example of a new port:
+static constexpr portSchema PORTX  = { X,  SEND_BATTERY_VOLTAGE | SEND_NEW_SENSOR, PAYLOAD_FORMAT::FIXED };
+   or of a new bit packed port - it needs its own port number so the decoder knows the payload format:
+static constexpr portSchema PORTY  = { Y,  SEND_BATTERY_VOLTAGE | SEND_NEW_SENSOR, PAYLOAD_FORMAT::BIT_PACKED };
+   (likewise PAYLOAD_FORMAT::PRESENCE_BITMAP to leave invalid fields out of the payload)
+*/
+// clang-format on
 
-const portSchema PORT59 = {
-    59,   // port_number
-    true, // sendBatteryVoltage
-    true, // sendTemperature
-    true, // sendRelativeHumidity
-    true, // sendAirPressure
-    true, // sendGasResistance
-    true, // sendLocation
-    false // sendCurrentSensor
+/**
+ * @brief Registry of all the defined ports, used by getPort().
+ * To add a new port define it above and add it here.
+ */
+static constexpr portSchema PORT_REGISTRY[] = {
+    PORT1,  PORT2,  PORT3,  PORT4,  PORT5,  PORT6,  PORT7,  PORT8,  PORT9,  PORT10, PORT11, PORT12, PORT13,
+    PORT14, PORT15,
+    PORT50, PORT51, PORT52, PORT53, PORT54, PORT55, PORT56, PORT57, PORT58, PORT59,
 };
 
+#define MAX_APP_PORT_NUMBER 223 /**< Ports 224-255 are reserved by the LoRaWAN spec. */
 
-
-/* An example of a new port:
-const portSchema PORTX = {
-    X,     // port_number
-    false, // sendBatteryVoltage
-    false, // sendTemperature
-    false, // sendRelativeHumidity
-    false, // sendAirPressure
-    false, // sendGasResistance
-    false  // sendLocation
-};
-*/
-
-#endif // PORT_SCHEMA_H
\ No newline at end of file
+#endif // PORT_SCHEMA_H
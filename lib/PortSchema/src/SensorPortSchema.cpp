@@ -1,5 +1,47 @@
 #include "SensorPortSchema.h"
 
+/**
+ * @brief MSB byte encodes the bits of one value, using the unrolled bigEndian store for the value's size.
+ * @param buffer Buffer for the data to be written into.
+ * @param bits Bits of the value.
+ * @param value_bytes Number of bytes of the value.
+ */
+static inline void storeValue(uint8_t *buffer, uint32_t bits, uint8_t value_bytes) {
+    switch (value_bytes) {
+        case 1:
+            bigEndian<1>::store(buffer, bits);
+            break;
+        case 2:
+            bigEndian<2>::store(buffer, bits);
+            break;
+        case 3:
+            bigEndian<3>::store(buffer, bits);
+            break;
+        default:
+            bigEndian<4>::store(buffer, bits);
+            break;
+    }
+}
+
+/**
+ * @brief MSB byte decodes the bits of one value, using the unrolled bigEndian load for the value's size.
+ * @param buffer Buffer that data will be decoded from.
+ * @param value_bytes Number of bytes of the value.
+ * @return Bits of the value.
+ */
+static inline uint32_t loadValue(const uint8_t *buffer, uint8_t value_bytes) {
+    switch (value_bytes) {
+        case 1:
+            return bigEndian<1>::load(buffer);
+        case 2:
+            return bigEndian<2>::load(buffer);
+        case 3:
+            return bigEndian<3>::load(buffer);
+        default:
+            return bigEndian<4>::load(buffer);
+    }
+}
+
 /**
  * @brief Byte encodes the given sensor data into the payload according to the given sensor port schema.
  * If the sensor data is not valid, for whatever reason, a value close to max (for the number of bytes) will be
@@ -15,12 +57,12 @@
  */
 template <typename T>
 uint8_t encodeDataWithSchema(T sensor_data, bool valid, uint8_t *payload_buffer, uint8_t buf_pos, const sensorPortSchema *sensor_schema) {
-    long long data_to_encode = 0;
+    int64_t data_to_encode = 0;
     // Check validity
     if (valid) {
-        /* Perform float maths to scale the data and assign the result to an int.
+        /* Perform fixed-point maths to scale the data to an int.
          * This discards any decimal values not captured by the scale factor */
-        data_to_encode = (long long)((double)sensor_data * (double)sensor_schema->scale_factor);
+        data_to_encode = scaleToFixedPoint(sensor_data, sensor_schema->scale_num, sensor_schema->scale_den);
     } else {
         /* If the data is invalid, a (close to) max value will be sent through.
          * A max value received by the decoder should be ignored */
@@ -38,23 +80,13 @@ uint8_t encodeDataWithSchema(T sensor_data, bool valid, uint8_t *payload_buffer,
 
     // The total bytes assigned to the sensor is assumed to be split equally amongst the number of values used
     // to represent the sensor data.
-    int data_size = sensor_schema->n_bytes / sensor_schema->n_values;
-
-    // Bitwise encode the data
-    uint8_t i = 0;
-    uint8_t j = (data_size - 1);
-    for (; i < data_size; i++, j--) {
-        // This is a generalised form of basic MSB bitwise encoding
-        uint8_t bitshift = j * 8; // 8 bits in a byte
-        if (j > 0) {
-            payload_buffer[buf_pos + i] = (uint8_t)((data_to_encode & (0xFF << bitshift)) >> bitshift);
-        } else {
-            payload_buffer[buf_pos + i] = (uint8_t)(data_to_encode & 0xFF);
-        }
-    }
+    uint8_t data_size = sensor_schema->n_bytes / sensor_schema->n_values;
+
+    // MSB encode the data - fields are at most 4 bytes, so only the low 32 bits (two's complement if negative) are needed
+    storeValue(&payload_buffer[buf_pos], (uint32_t)data_to_encode, data_size);
 
     // return the new buffer length
-    return (buf_pos + i);
+    return (buf_pos + data_size);
 }
 
 /**
@@ -64,11 +96,11 @@ uint8_t encodeDataWithSchema(T sensor_data, bool valid, uint8_t *payload_buffer,
  */
 
 uint8_t sensorPortSchema::encodeData(uint8_t sensor_data, bool valid, uint8_t *payload_buffer, uint8_t current_buffer_len) const {
-    return (encodeDataWithSchema(sensor_data, valid, payload_buffer, current_buffer_len, this));
+    return (encodeDataWithSchema((uint32_t)sensor_data, valid, payload_buffer, current_buffer_len, this));
 }
 
 uint8_t sensorPortSchema::encodeData(uint16_t sensor_data, bool valid, uint8_t *payload_buffer, uint8_t current_buffer_len) const {
-    return (encodeDataWithSchema(sensor_data, valid, payload_buffer, current_buffer_len, this));
+    return (encodeDataWithSchema((uint32_t)sensor_data, valid, payload_buffer, current_buffer_len, this));
 }
 
 uint8_t sensorPortSchema::encodeData(uint32_t sensor_data, bool valid, uint8_t *payload_buffer, uint8_t current_buffer_len) const {
@@ -97,34 +129,28 @@ uint8_t sensorPortSchema::encodeData(float sensor_data, bool valid, uint8_t *pay
  */
 template <typename T>
 uint8_t decodeDataWithSchema(T *sensor_data, bool *valid, uint8_t *buffer, uint8_t buf_pos, const sensorPortSchema *sensor_schema) {
-    long long data_to_decode = 0;
-
     // The total bytes assigned to the sensor is assumed to be split equally amongst the number of values used
     // to represent the sensor data.
-    int data_size = sensor_schema->n_bytes / sensor_schema->n_values;
-
-    // Bitwise decode the data
-    uint8_t i = 0;
-    uint8_t j = (data_size - 1);
-    for (; i < data_size; i++, j--) {
-        // This is a generalised form of basic MSB bitwise decoding
-        uint8_t bitshift = j * 8; // 8 bits in a byte
-        if (j > 0) {
-            data_to_decode += (long long)(buffer[buf_pos + i] << bitshift);
-        } else {
-            data_to_decode += (long long)(buffer[buf_pos + i]);
-        }
-    }
+    uint8_t data_size = sensor_schema->n_bytes / sensor_schema->n_values;
+
+    // MSB decode the data
+    uint32_t data_to_decode = loadValue(&buffer[buf_pos], data_size);
 
-    if ((sensor_schema->is_signed && (data_to_decode == 0x7F7F7F7F)) || (data_to_decode == 0xFFFFFFFF)) {
+    // The invalid value is the segment of 0x7F7F7F7F (signed) or 0xFFFFFFFF (unsigned) that fits in data_size bytes
+    if (data_to_decode == invalidFieldValue(sensor_schema->is_signed, data_size)) {
         *valid = false;
     } else {
         *valid = true;
-        *sensor_data = (T)(((double)data_to_decode) / (double)sensor_schema->scale_factor);
+        if (sensor_schema->is_signed) {
+            scaleFromFixedPoint(signExtend(data_to_decode, data_size), sensor_data, sensor_schema->scale_num,
+                                sensor_schema->scale_den);
+        } else {
+            scaleFromFixedPoint(data_to_decode, sensor_data, sensor_schema->scale_num, sensor_schema->scale_den);
+        }
     }
 
     // return the new buffer length
-    return (buf_pos + i);
+    return (buf_pos + data_size);
 }
 
 /**
@@ -152,3 +178,134 @@ uint8_t sensorPortSchema::decodeData(int *sensor_data, bool *valid, uint8_t *buf
 uint8_t sensorPortSchema::decodeData(float *sensor_data, bool *valid, uint8_t *buffer, uint8_t buff_pos) const {
     return (decodeDataWithSchema(sensor_data, valid, buffer, buff_pos, this));
 }
+
+/**
+ * @brief Checks the given sensor data is within min_value - max_value of the sensor port schema.
+ * @param sensor_data Sensor data to check.
+ * @param sensor_schema Sensor port schema with the range.
+ * @return True if in range, false if it will be clamped.
+ */
+static bool inBitRange(float sensor_data, const sensorPortSchema *sensor_schema) {
+    return (sensor_data >= (float)sensor_schema->min_value) && (sensor_data <= (float)sensor_schema->max_value);
+}
+
+static bool inBitRange(uint32_t sensor_data, const sensorPortSchema *sensor_schema) {
+    return ((int64_t)sensor_data >= sensor_schema->min_value) && ((int64_t)sensor_data <= sensor_schema->max_value);
+}
+
+/**
+ * @brief Maps the given sensor data onto the bit encoded steps of the sensor port schema, clamping it to
+ * min_value - max_value.
+ * The overloads keep to single-precision float maths for float data and integer maths for integer data.
+ * @param sensor_data Sensor data.
+ * @param sensor_schema Sensor port schema that determines how the data is encoded.
+ * @return Bit encoded value (0 - bitSteps()).
+ */
+static uint32_t valueToBits(float sensor_data, const sensorPortSchema *sensor_schema) {
+    float range = (float)sensor_schema->max_value - (float)sensor_schema->min_value;
+    float bits = (sensor_data - (float)sensor_schema->min_value) * ((float)sensor_schema->bitSteps() / range) + 0.5f;
+    if (!(bits > 0)) { // also catches NaN
+        return 0;
+    }
+    return (bits >= (float)sensor_schema->bitSteps()) ? sensor_schema->bitSteps() : (uint32_t)bits;
+}
+
+static uint32_t valueToBits(uint32_t sensor_data, const sensorPortSchema *sensor_schema) {
+    if ((int64_t)sensor_data <= sensor_schema->min_value) {
+        return 0;
+    } else if ((int64_t)sensor_data >= sensor_schema->max_value) {
+        return sensor_schema->bitSteps();
+    }
+    uint32_t range = (uint32_t)sensor_schema->max_value - (uint32_t)sensor_schema->min_value;
+    uint32_t offset = sensor_data - (uint32_t)sensor_schema->min_value;
+    if (range == sensor_schema->bitSteps()) {
+        return offset; // one step per unit, no scaling needed
+    }
+    return (uint32_t)(((uint64_t)offset * sensor_schema->bitSteps() + range / 2) / range);
+}
+
+/**
+ * @brief Maps the bit encoded value back onto min_value - max_value of the sensor port schema.
+ * @param bits Bit encoded value (0 - bitSteps()).
+ * @param sensor_data Resulting sensor data.
+ * @param sensor_schema Sensor port schema that determines how the data is decoded.
+ */
+static void bitsToValue(uint32_t bits, float *sensor_data, const sensorPortSchema *sensor_schema) {
+    float range = (float)sensor_schema->max_value - (float)sensor_schema->min_value;
+    *sensor_data = (float)sensor_schema->min_value + (float)bits * (range / (float)sensor_schema->bitSteps());
+}
+
+static void bitsToValue(uint32_t bits, uint32_t *sensor_data, const sensorPortSchema *sensor_schema) {
+    uint32_t range = (uint32_t)sensor_schema->max_value - (uint32_t)sensor_schema->min_value;
+    if (range != sensor_schema->bitSteps()) {
+        bits = (uint32_t)(((uint64_t)bits * range + sensor_schema->bitSteps() / 2) / sensor_schema->bitSteps());
+    }
+    *sensor_data = (uint32_t)sensor_schema->min_value + bits;
+}
+
+/**
+ * @brief Bit encodes the given sensor data into the payload according to the given sensor port schema.
+ * The data is clamped to the schema's min_value - max_value, with a warning as the decoded value will not match.
+ * If the data is invalid n_bits of ones are encoded instead.
+ * @param sensor_data Sensor data to encode. This template allows the type of sensor_data to be flexible (to a point).
+ * @param valid Validity of given sensor data.
+ * @param payload_buffer LoRaWAN payload with buffer for data to be written into.
+ * @param bit_pos Start encoding from this bit.
+ * @param sensor_schema Sensor port schema that determines how the data is encoded.
+ * @return New total length (in bits) of data encoded to payload_buffer - includes bit_pos.
+ */
+template <typename T>
+uint16_t encodeBitsWithSchema(T sensor_data, bool valid, uint8_t *payload_buffer, uint16_t bit_pos, const sensorPortSchema *sensor_schema) {
+    uint32_t data_to_encode = sensor_schema->invalidBits();
+    if (valid) {
+        if (!inBitRange(sensor_data, sensor_schema)) {
+            log(LOG_LEVEL::WARN, "Sensor data is outside the bit packed range of its sensor port schema, it is clamped.");
+        }
+        data_to_encode = valueToBits(sensor_data, sensor_schema);
+    }
+
+    storeBits(payload_buffer, bit_pos, data_to_encode, sensor_schema->n_bits);
+    return (bit_pos + sensor_schema->n_bits);
+}
+
+uint16_t sensorPortSchema::encodeBits(float sensor_data, bool valid, uint8_t *payload_buffer, uint16_t bit_pos) const {
+    return (encodeBitsWithSchema(sensor_data, valid, payload_buffer, bit_pos, this));
+}
+
+uint16_t sensorPortSchema::encodeBits(uint32_t sensor_data, bool valid, uint8_t *payload_buffer, uint16_t bit_pos) const {
+    return (encodeBitsWithSchema(sensor_data, valid, payload_buffer, bit_pos, this));
+}
+
+/**
+ * @brief Bit decodes the given buffer into the sensor data according to the given sensor port schema.
+ * If the sensor data is not valid, for whatever reason, the valid flag will be set to false and no data will be decoded
+ * to sensor_data.
+ * @param sensor_data Resulting decoded sensor data. This template allows the type of sensor_data to be flexible (to a
+ * point).
+ * @param valid Validity of the decoded sensor data.
+ * @param buffer Buffer that data will be decoded from.
+ * @param bit_pos Start decoding from this bit.
+ * @param sensor_schema Sensor port schema that determines how the data is decoded.
+ * @return New total length (in bits) of data decoded from buffer - includes bit_pos.
+ */
+template <typename T>
+uint16_t decodeBitsWithSchema(T *sensor_data, bool *valid, uint8_t *buffer, uint16_t bit_pos, const sensorPortSchema *sensor_schema) {
+    uint32_t data_to_decode = loadBits(buffer, bit_pos, sensor_schema->n_bits);
+
+    if (data_to_decode == sensor_schema->invalidBits()) {
+        *valid = false;
+    } else {
+        *valid = true;
+        bitsToValue(data_to_decode, sensor_data, sensor_schema);
+    }
+
+    return (bit_pos + sensor_schema->n_bits);
+}
+
+uint16_t sensorPortSchema::decodeBits(float *sensor_data, bool *valid, uint8_t *buffer, uint16_t bit_pos) const {
+    return (decodeBitsWithSchema(sensor_data, valid, buffer, bit_pos, this));
+}
+
+uint16_t sensorPortSchema::decodeBits(uint32_t *sensor_data, bool *valid, uint8_t *buffer, uint16_t bit_pos) const {
+    return (decodeBitsWithSchema(sensor_data, valid, buffer, bit_pos, this));
+}
@@ -15,6 +15,7 @@
 
 #include <math.h>
 #include <stdint.h>
+#include "FieldCodec.h"     /**< Fixed-point scaling, byte packing & the compile time FieldCodec. */
 #include "Logging.h"        /**< Go here to change the logging level for the entire application. */
 
 
@@ -54,6 +55,22 @@ struct sensorData {
         bool is_valid;
         float ADCval;
     } current_A; /**< Current sensor A. */
+    struct {
+        float rms;
+        float peak;
+        bool is_valid;
+    } ac_current; /**< AC current A: true-RMS & peak over whole mains cycles, with the DC removed. */
+    struct {
+        float fundamental;
+        float h3;
+        float h5;
+        float h7;
+        bool is_valid;
+    } harmonics; /**< Current harmonics A RMS: the mains fundamental, then its 3rd, 5th & 7th harmonics. */
+    struct {
+        float value;
+        bool is_valid;
+    } thd; /**< Total harmonic distortion of the current: % of the fundamental (3rd, 5th & 7th harmonics only). */
 };
 
 /** @brief sensorPortSchema describes how each sensors data should be encoded. */
@@ -61,13 +78,41 @@ class sensorPortSchema {
   public:
     uint8_t n_bytes;    /**< Total length in payload - assumed to be split equally amongst n_values. */
     uint8_t n_values;   /**< Number of values sent for sensor data. */
-    float scale_factor; /**< Only int values are encoded. To send a float value, mulitply by scale_factor to encode;
-                             then divide by scale_factor to decode. */
+    uint32_t scale_num; /**< Only int values are encoded. The scale factor is the fixed-point ratio scale_num/scale_den:
+                             to send a float value, mulitply by it to encode; then divide by it to decode. */
+    uint32_t scale_den; /**< Denominator of the scale factor, 1 for power of ten (decimal place) scales. */
     bool is_signed;     /**< Value has a sign and hence can be negative. */
+    uint8_t n_bits;     /**< BIT_PACKED payload format only: bits per value (1 - 32). The all ones value is kept to
+                             indicate invalid data, the rest are spread evenly over min_value to max_value. */
+    int32_t min_value;  /**< BIT_PACKED payload format only: lowest value sent, lower values are clamped to it. */
+    int32_t max_value;  /**< BIT_PACKED payload format only: highest value sent, higher values are clamped to it. */
+    uint8_t delta_bits; /**< Delta encoding only: bits per change of a value since the last frame (2 - 16), in steps of
+                             the scale factor. Sized for the typical change between frames. */
+
+    /**
+     * @brief Get the scale factor as a float, i.e. scale_num/scale_den.
+     * @return Scale factor (multiplier) applied when encoding.
+     */
+    constexpr float scaleFactor(void) const { return (float)scale_num / (float)scale_den; }
+
+    /**
+     * @brief Get the value bit encoded to indicate invalid data in the BIT_PACKED payload format, i.e. n_bits of ones.
+     * @return The invalid value.
+     */
+    constexpr uint32_t invalidBits(void) const { return 0xFFFFFFFFUL >> (32 - n_bits); }
+
+    /**
+     * @brief Get the number of steps min_value to max_value is split into in the BIT_PACKED payload format.
+     * The resolution of the bit encoded value is (max_value - min_value) / bitSteps().
+     * @return Number of steps, i.e. the largest valid bit encoded value.
+     */
+    constexpr uint32_t bitSteps(void) const { return invalidBits() - 1; }
 
     /**
      * @brief Byte encodes the given sensor data into the payload according to the sensor port schema.
      * @details Calls a template function defined in PortSchema.cpp that can take in sensor_data of various types.
+     * Scaling is done in fixed-point: integer data only uses integer maths and float data only uses single-precision
+     * maths, so the encoding never falls back on the (software) double-precision library of the nRF52840.
      * Feel free to add a new sensor_data type overload of encodeData() if necessary.
      * If the sensor data is not valid, for whatever reason, a value close to max (for the number of bytes) will be
      * encoded instead. The decoder then knows to ignore the data as it is invalid. If the data is invalid a segment of
@@ -88,6 +133,7 @@ class sensorPortSchema {
     /**
      * @brief Byte decodes the given buffer into the sensor data according to the given sensor port schema.
      * @details Calls a template function defined in PortSchema.cpp that can return sensor_data of various types.
+     * As with encodeData() only integer or single-precision maths is used to undo the scaling.
      * Feel free to add a new sensor_data type overload of decodeData() if necessary.
      * If the sensor data is not valid, for whatever reason, the valid flag will be set to false and no data will be
      * decoded to sensor_data.
@@ -102,76 +148,206 @@ class sensorPortSchema {
     uint8_t decodeData(uint8_t *sensor_data, bool *valid, uint8_t *buffer, uint8_t buff_pos) const;
     uint8_t decodeData(uint16_t *sensor_data, bool *valid, uint8_t *buffer, uint8_t buff_pos) const;
     uint8_t decodeData(uint32_t *sensor_data, bool *valid, uint8_t *buffer, uint8_t buff_pos) const;
+
+    /**
+     * @brief Bit encodes the given sensor data into the payload according to the sensor port schema, for the BIT_PACKED
+     * payload format.
+     * @details The data is clamped to min_value - max_value and mapped evenly onto n_bits, which are MSB encoded from
+     * any bit of the payload (values are not byte aligned). Float data only uses single-precision maths, and integer
+     * data integer maths.
+     * If the sensor data is not valid, for whatever reason, n_bits of ones are encoded instead.
+     * @param sensor_data Sensor data to encode (valid data types: float, uint32_t).
+     * @param valid Validity of given sensor data.
+     * @param payload_buffer Payload buffer for data to be written into.
+     * @param bit_pos Start encoding from this bit of payload_buffer.
+     * @return Total length (in bits) of data encoded to payload_buffer.
+     */
+    uint16_t encodeBits(float sensor_data, bool valid, uint8_t *payload_buffer, uint16_t bit_pos) const;
+    uint16_t encodeBits(uint32_t sensor_data, bool valid, uint8_t *payload_buffer, uint16_t bit_pos) const;
+
+    /**
+     * @brief Bit decodes the given buffer into the sensor data according to the sensor port schema, for the BIT_PACKED
+     * payload format.
+     * If the sensor data is not valid, for whatever reason, the valid flag will be set to false and no data will be
+     * decoded to sensor_data.
+     * @param sensor_data Resulting decoded sensor data (valid data types: float, uint32_t).
+     * @param valid Validity of sensor data.
+     * @param buffer Buffer that data will be decoded from.
+     * @param bit_pos Start decoding from this bit of buffer.
+     * @return Total length (in bits) of data decoded from buffer.
+     */
+    uint16_t decodeBits(float *sensor_data, bool *valid, uint8_t *buffer, uint16_t bit_pos) const;
+    uint16_t decodeBits(uint32_t *sensor_data, bool *valid, uint8_t *buffer, uint16_t bit_pos) const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // SCHEMA DEFINITIONS: See readme for definitions in tabular format.
 
-static const sensorPortSchema timestampSchema = { // units: s
+static constexpr sensorPortSchema timestampSchema = { // units: s
     .n_bytes = 4,
     .n_values = 1,
-    .scale_factor = 1,
-    .is_signed = false
+    .scale_num = 1,
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 31, // 1 s steps until 2038
+    .min_value = 0,
+    .max_value = 2147483646,
+    .delta_bits = 8 // up to ~2 min between frames
 };
 
-static const sensorPortSchema batteryVoltageSchema = { // units: mV
+static constexpr sensorPortSchema timeOffsetSchema = { // units: s, time since the previous sample of a batch
+    .n_bytes = 1,
+    .n_values = 1,
+    .scale_num = 1,
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 8,
+    .min_value = 0,
+    .max_value = 254,
+    .delta_bits = 4
+};
+
+static constexpr sensorPortSchema batteryVoltageSchema = { // units: mV
     .n_bytes = 2,
     .n_values = 1,
-    .scale_factor = 1,
-    .is_signed = false
+    .scale_num = 1,
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 12, // 1 mV steps
+    .min_value = 2000,
+    .max_value = 6094,
+    .delta_bits = 4 // -8 to +6 mV
 };
 
-static const sensorPortSchema temperatureSchema = { // units: degrees C
+static constexpr sensorPortSchema temperatureSchema = { // units: degrees C
     .n_bytes = 2,
     .n_values = 1,
-    .scale_factor = pow(10.0, 2), // 2 decimal places
-    .is_signed = true
+    .scale_num = 100, // 2 decimal places
+    .scale_den = 1,
+    .is_signed = true,
+    .n_bits = 14, // ~0.008 C steps over the sensor range
+    .min_value = -40,
+    .max_value = 85,
+    .delta_bits = 6 // -0.32 to +0.30 C
 };
 
 /** NOTE: relativeHumidity could instead have the same schema as temperature if more resolution is desired. */
-static const sensorPortSchema relativeHumiditySchema = { // units: %
+static constexpr sensorPortSchema relativeHumiditySchema = { // units: %
     .n_bytes = 1,
     .n_values = 1,
-    .scale_factor = (float)(UINT8_MAX / 100.0), // percentage (0->100) is scaled to a byte (0->255)
-    .is_signed = false
+    .scale_num = UINT8_MAX, // percentage (0->100) is scaled to a byte (0->255)
+    .scale_den = 100,
+    .is_signed = false,
+    .n_bits = 7, // ~0.8 % steps, sensor accuracy is +-2 %
+    .min_value = 0,
+    .max_value = 100,
+    .delta_bits = 4 // ~-3 to +2 %
 };
 
-static const sensorPortSchema airPressureSchema = { // units: Pa
+static constexpr sensorPortSchema airPressureSchema = { // units: Pa
     .n_bytes = 4,
     .n_values = 1,
-    .scale_factor = 1,
-    .is_signed = false
+    .scale_num = 1,
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 17, // ~0.6 Pa steps over the sensor range
+    .min_value = 30000,
+    .max_value = 110000,
+    .delta_bits = 6 // -32 to +30 Pa
 };
 
-static const sensorPortSchema gasResistanceSchema = { // units: ??
+static constexpr sensorPortSchema gasResistanceSchema = { // units: ??
     .n_bytes = 4,
     .n_values = 1,
-    .scale_factor = 1,
-    .is_signed = false
+    .scale_num = 1,
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 24, // steps of 1
+    .min_value = 0,
+    .max_value = 16777214,
+    .delta_bits = 12 // -2048 to +2046, the gas resistance is noisy
 };
 
-static const sensorPortSchema locationSchema = { // units: degrees
+static constexpr sensorPortSchema locationSchema = { // units: degrees
     .n_bytes = 8,                                // split equally: 4 bytes lat, 4 bytes lng
     .n_values = 2,                               // lat and lng
-    .scale_factor = pow(10.0, 4),                // 4 decimal places
-    .is_signed = true
+    .scale_num = 10000,                          // 4 decimal places
+    .scale_den = 1,
+    .is_signed = true,
+    .n_bits = 22,                                // ~0.0001 degree (~10 m) steps
+    .min_value = -180,
+    .max_value = 180,
+    .delta_bits = 4                              // -0.0008 to +0.0006 degrees, i.e. stationary
 };
 
-static const sensorPortSchema currentSensorSchema = { // units: A
+static constexpr sensorPortSchema currentSensorSchema = { // units: A
     // chaned vals to 2 and bytes to 4
     .n_bytes = 6,
     .n_values = 2,      // could try changing this for future iterations (add more values)
-    .scale_factor = pow(10.0, 2), // 2 decimal places
-    .is_signed = true
+    .scale_num = 100,   // 2 decimal places
+    .scale_den = 1,
+    .is_signed = true,
+    .n_bits = 19,       // ~0.007 steps, covers both the current (A) & ADC (mV) values
+    .min_value = -100,
+    .max_value = 3600,
+    .delta_bits = 10    // -5.12 to +5.10
 };
 
+static constexpr sensorPortSchema acCurrentSchema = { // units: A
+    .n_bytes = 4,       // split equally: 2 bytes RMS, 2 bytes peak
+    .n_values = 2,      // RMS and peak
+    .scale_num = 100,   // 2 decimal places
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 14,       // ~0.01 A steps
+    .min_value = 0,
+    .max_value = 163,
+    .delta_bits = 10    // -5.12 to +5.10 A
+};
+
+static constexpr sensorPortSchema harmonicsSchema = { // units: A
+    .n_bytes = 8,       // split equally: 2 bytes each of the fundamental, 3rd, 5th & 7th harmonics
+    .n_values = 4,      // fundamental, 3rd, 5th & 7th harmonics
+    .scale_num = 100,   // 2 decimal places
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 14,       // ~0.01 A steps
+    .min_value = 0,
+    .max_value = 163,
+    .delta_bits = 10    // -5.12 to +5.10 A
+};
+
+static constexpr sensorPortSchema thdSchema = { // units: %
+    .n_bytes = 2,
+    .n_values = 1,
+    .scale_num = 100,   // 2 decimal places
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 16,       // ~0.01 % steps
+    .min_value = 0,
+    .max_value = 655,   // can be over 100 %
+    .delta_bits = 10    // -5.12 to +5.10 %
+};
+
+/**
+ * @brief The FieldCodec of a sensorPortSchema, for encoding/decoding with the schema fixed at compile time.
+ * e.g. SchemaCodec<&temperatureSchema>::encode(sensor_data.temperature.value, true, payload_buffer);
+ */
+template <const sensorPortSchema *schema>
+using SchemaCodec = FieldCodec<schema->n_bytes, schema->n_values, schema->scale_num, schema->scale_den, schema->is_signed>;
+
 /* An example of a new sensor:
-static const sensorPortSchema newSensorSchema = {
+static constexpr sensorPortSchema newSensorSchema = {
     .n_bytes = 1,
     .n_values = 1,
-    .scale_factor = 1,
-    .is_signed = false
+    .scale_num = 1,
+    .scale_den = 1,
+    .is_signed = false,
+    .n_bits = 8,
+    .min_value = 0,
+    .max_value = 254,
+    .delta_bits = 4
 };
 */
 
@@ -0,0 +1,132 @@
+/**
+ * @file main.cpp
+ * @author Kalina Knight
+ * @brief A benchmark of the current sensor sample accumulation.
+ * Compares the cycle count of the original per sample float accumulation of readCurrentAmp() (copied below as the
+ * "legacy" path) to the integer adcSampleSums now used by every AnalogSensor, over the same block of synthetic raw
+ * samples. Also reports how far each result is from the exact (double precision) current.
+ * Uses the DWT cycle counter of the Cortex-M4F, so the results are in CPU cycles (64 MHz on the nRF52840).
+ * This example does not use the ADC or LoRa at all, it only prints the results.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+
+#include "AnalogSensor.h" /**< Go here to see the adcSampleSums. */
+#include "Logging.h"      /**< Go here to change the logging level for the entire application. */
+
+// Number of times each accumulation is repeated, the cycle count is averaged over these.
+#define BENCHMARK_ITERATIONS 20
+#define BENCHMARK_SAMPLES 2000 // Same as CurrentSensor::numberOfSamples
+
+CurrentSensor current_sensor;
+int16_t raw_samples[BENCHMARK_SAMPLES] = {};
+volatile float current_result; // volatile so the accumulation isn't optimised away
+
+/**
+ * @brief The original readCurrentAmp() accumulation, kept here as the reference for the benchmark.
+ */
+__attribute__((noinline)) float legacyCurrentAmp(const int16_t *samples, int n_samples, float real_mv_per_lsb,
+                                                 float zero_offset) {
+    float current_sample_sum = 0;
+    float adc_sum = 0;
+    for (int i = 0; i < n_samples; i++) {
+        float raw_adc = samples[i];
+        float current_sensor_mv = (raw_adc * real_mv_per_lsb) + zero_offset;
+        adc_sum = raw_adc + adc_sum;
+        float current_sample = (current_sensor_mv - 2500) * 0.032;
+        current_sample_sum = current_sample_sum + current_sample;
+    }
+    return current_sample_sum / n_samples;
+}
+
+/**
+ * @brief The integer accumulation, in blocks as the samples arrive from an acquisition.
+ */
+__attribute__((noinline)) float integerCurrentAmp(const int16_t *samples, int n_samples, float real_mv_per_lsb,
+                                                  float zero_offset) {
+    adcSampleSums sums;
+    for (int i = 0; i < n_samples; i += ADC_BLOCK_SAMPLES) {
+        int n = ((n_samples - i) < ADC_BLOCK_SAMPLES) ? (n_samples - i) : ADC_BLOCK_SAMPLES;
+        sums.addBlock(&samples[i], n);
+    }
+    return ((sums.mean() * real_mv_per_lsb) + zero_offset - CURRENT_SENSOR_ZERO_MV) * CURRENT_SENSOR_A_PER_MV;
+}
+
+/**
+ * @brief Start the DWT cycle counter.
+ */
+void initCycleCounter(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Benchmarks both accumulations of the raw samples and logs the average cycles per reading & their error.
+ */
+void runAccumulationBenchmark(void) {
+    float real_mv_per_lsb = current_sensor.real_MV_per_LSB;
+    float zero_offset = 12.5;
+
+    // exact current
+    double exact_sum = 0;
+    for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+        exact_sum += ((raw_samples[i] * (double)real_mv_per_lsb) + zero_offset - 2500) * 0.032;
+    }
+    double exact_current = exact_sum / BENCHMARK_SAMPLES;
+
+    uint32_t start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        current_result = legacyCurrentAmp(raw_samples, BENCHMARK_SAMPLES, real_mv_per_lsb, zero_offset);
+    }
+    uint32_t legacy_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+    float legacy_current = current_result;
+
+    start = DWT->CYCCNT;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        current_result = integerCurrentAmp(raw_samples, BENCHMARK_SAMPLES, real_mv_per_lsb, zero_offset);
+    }
+    uint32_t integer_cycles = (DWT->CYCCNT - start) / BENCHMARK_ITERATIONS;
+    float integer_current = current_result;
+
+    log(LOG_LEVEL::INFO, "%d samples | float: %6lu cycles (%lu per sample) | integer: %6lu cycles (%lu per sample)",
+        BENCHMARK_SAMPLES, legacy_cycles, legacy_cycles / BENCHMARK_SAMPLES, integer_cycles,
+        integer_cycles / BENCHMARK_SAMPLES);
+    log(LOG_LEVEL::INFO, "exact: %.6f A | float error: %.6f A | integer error: %.6f A", exact_current,
+        legacy_current - exact_current, integer_current - exact_current);
+}
+
+/**
+ * @brief Setup code runs once on reset/startup.
+ */
+void setup() {
+    // initialise the logging module - function does nothing if APP_LOG_LEVEL in Logging.h = NONE
+    initLogging();
+    log(LOG_LEVEL::INFO,
+        "\n============================================"
+        "\nWelcome to ADC Sample Accumulation Benchmark"
+        "\n============================================");
+
+    initCycleCounter();
+    current_sensor.setCompensationFactor(CURRENT_SENSOR_COMPENSATION_FACTOR);
+
+    // synthetic 12-bit samples of a noisy ~4A load
+    randomSeed(2021);
+    for (int i = 0; i < BENCHMARK_SAMPLES; i++) {
+        raw_samples[i] = 2150 + random(-40, 41);
+    }
+    runAccumulationBenchmark();
+}
+
+/**
+ * @brief Loop code runs repeated after setup().
+ */
+void loop() {
+    // nothing to do, the benchmark runs once in setup()
+    delay(UINT32_MAX - 1);
+}
@@ -25,7 +25,7 @@
 // PORT/SENSOR SELECTION
 // The chosen port determines the sensor data included in the payload - see
 // PortSchema.h E.g. port 3: battery voltage + temperature This example uses the
-// RAK1901 for temp - change initSensors to switch to the 1906
+// RAK1901 for temp - or the RAK1906 if it is plugged in, see sensorDrivers
 portSchema payload_port = PORT10;
 
 // Sensor reading interval in [ms] = 10 seconds.
@@ -51,7 +51,7 @@ void setup() {
         "\n========================================");
 
     // Init sensors according to payload_port selected
-    if (!initSensors(&payload_port, true, false)) {
+    if (!initSensors(&payload_port)) {
         return;
     }
 
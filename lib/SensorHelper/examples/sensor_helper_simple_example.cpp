@@ -22,7 +22,7 @@
 // PORT/SENSOR SELECTION
 // The chosen port determines the sensor data included in the payload - see PortSchema.h
 // E.g. port 3: battery voltage + temperature
-// This example uses the RAK1901 for temp - change initSensors to switch to the 1906
+// This example uses the RAK1901 for temp - or the RAK1906 if it is plugged in, see sensorDrivers
 portSchema payload_port = PORT3;
 
 sensorData sensor_data = {};
@@ -42,7 +42,7 @@ void setup() {
         "\n=======================================");
 
     // Init sensors according to payload_port selected
-    if (!initSensors(&payload_port, true, false)) {
+    if (!initSensors(&payload_port)) {
         // error init-ing sensors
         while (true) {
             delay(UINT32_MAX - 1);
@@ -0,0 +1,524 @@
+#include "AdcAcquisition.h"
+#include "AdcSettings.h"
+
+#ifdef SOFTDEVICE_PRESENT
+#include "nrf_sdm.h"
+#include "nrf_soc.h"
+#endif
+
+// State of the running acquisition, shared with the SAADC interrupt
+static adcAcquisitionConfig acquisition = {};
+static int16_t sample_blocks[2][ADC_BLOCK_SAMPLES]; /**< DMA sample blocks, one filled while the other is handled. */
+static volatile uint16_t block_length[2] = {};      /**< Samples the SAADC was given to fill each block with. */
+static volatile uint8_t active_block = 0;           /**< Block the SAADC is filling. */
+static volatile uint32_t samples_total = 0;         /**< Samples to acquire, of every channel. */
+static uint16_t block_capacity = ADC_BLOCK_SAMPLES; /**< Samples of whole scans that fit in a block. */
+static volatile uint32_t samples_queued = 0;        /**< Samples given to the SAADC so far. */
+static volatile uint32_t samples_done = 0;          /**< Samples handled so far. */
+static volatile bool acquisition_running = false;
+static volatile bool finish_requested = false; /**< Set by finishAdcAcquisition() to end after the handled block. */
+static SemaphoreHandle_t acquisition_done = NULL; /**< Given by the interrupt when the last block has been handled. */
+
+// State of the limit monitor, shared with the SAADC interrupt
+static adcLimitConfig monitor = {};
+static int16_t monitor_result = 0; /**< DMA buffer of the monitor's samples, only the limit events are used. */
+static volatile bool monitor_running = false;
+
+/**
+ * @brief Get the SAADC input of an analog pin, the same mapping as analogRead().
+ * @param pin Arduino pin number.
+ * @return SAADC_CH_PSELP_PSELP_AnalogInputX, or SAADC_CH_PSELP_PSELP_NC if not an analog pin.
+ */
+static uint32_t saadcInput(uint8_t pin) {
+    if (pin >= PINS_COUNT) {
+        return SAADC_CH_PSELP_PSELP_NC;
+    }
+    switch (g_ADigitalPinMap[pin]) {
+        case 2:
+            return SAADC_CH_PSELP_PSELP_AnalogInput0;
+        case 3:
+            return SAADC_CH_PSELP_PSELP_AnalogInput1;
+        case 4:
+            return SAADC_CH_PSELP_PSELP_AnalogInput2;
+        case 5:
+            return SAADC_CH_PSELP_PSELP_AnalogInput3;
+        case 28:
+            return SAADC_CH_PSELP_PSELP_AnalogInput4;
+        case 29:
+            return SAADC_CH_PSELP_PSELP_AnalogInput5;
+        case 30:
+            return SAADC_CH_PSELP_PSELP_AnalogInput6;
+        case 31:
+            return SAADC_CH_PSELP_PSELP_AnalogInput7;
+        default:
+            return SAADC_CH_PSELP_PSELP_NC;
+    }
+}
+
+/**
+ * @brief Get the SAADC channel gain & reference of an analog reference, the same as analogReference().
+ * @param analog_ref ADC analog reference.
+ * @param ch_config Resulting gain & reference bits of CH[n].CONFIG.
+ * @return True if the SAADC has the analog reference.
+ */
+static bool saadcGainReference(_eAnalogReference analog_ref, uint32_t *ch_config) {
+    uint32_t reference = SAADC_CH_CONFIG_REFSEL_Internal; // 0.6V
+    uint32_t gain;
+    switch (analog_ref) {
+        case AR_DEFAULT:
+            // same as case AR_INTERNAL
+        case AR_INTERNAL: // 0.6V Ref * 6 = 0..3.6V
+            gain = SAADC_CH_CONFIG_GAIN_Gain1_6;
+            break;
+        case AR_INTERNAL_3_0: // 0.6V Ref * 5 = 0..3.0V
+            gain = SAADC_CH_CONFIG_GAIN_Gain1_5;
+            break;
+        case AR_INTERNAL_2_4: // 0.6V Ref * 4 = 0..2.4V
+            gain = SAADC_CH_CONFIG_GAIN_Gain1_4;
+            break;
+        case AR_INTERNAL_1_8: // 0.6V Ref * 3 = 0..1.8V
+            gain = SAADC_CH_CONFIG_GAIN_Gain1_3;
+            break;
+        case AR_INTERNAL_1_2: // 0.6V Ref * 2 = 0..1.2V
+            gain = SAADC_CH_CONFIG_GAIN_Gain1_2;
+            break;
+        case AR_VDD4: // 3.3V Ref / 4 * 4 = 0..3.3V
+            reference = SAADC_CH_CONFIG_REFSEL_VDD1_4;
+            gain = SAADC_CH_CONFIG_GAIN_Gain1_4;
+            break;
+        default:
+            return false;
+    }
+    *ch_config = (gain << SAADC_CH_CONFIG_GAIN_Pos) | (reference << SAADC_CH_CONFIG_REFSEL_Pos);
+    return true;
+}
+
+/**
+ * @brief Get the SAADC RESOLUTION of an ADC resolution.
+ * @param analog_resolution ADC resolution [bits].
+ * @param resolution Resulting RESOLUTION value.
+ * @return True if the SAADC has the resolution.
+ */
+static bool saadcResolution(int analog_resolution, uint32_t *resolution) {
+    switch (analog_resolution) {
+        case 8:
+            *resolution = SAADC_RESOLUTION_VAL_8bit;
+            return true;
+        case 10:
+            *resolution = SAADC_RESOLUTION_VAL_10bit;
+            return true;
+        case 12:
+            *resolution = SAADC_RESOLUTION_VAL_12bit;
+            return true;
+        case 14:
+            *resolution = SAADC_RESOLUTION_VAL_14bit;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Get the SAADC OVERSAMPLE of an oversampling setting.
+ * @param oversampling Conversions averaged into each sample, 0 or 1 to disable.
+ * @param oversample Resulting OVERSAMPLE value (log2 of the oversampling).
+ * @return True if the SAADC has the oversampling, i.e. a power of 2 up to 256.
+ */
+static bool saadcOversample(uint32_t oversampling, uint32_t *oversample) {
+    if (oversampling <= 1) {
+        *oversample = SAADC_OVERSAMPLE_OVERSAMPLE_Bypass;
+        return true;
+    }
+    if ((oversampling > 256) || ((oversampling & (oversampling - 1)) != 0)) {
+        return false;
+    }
+    *oversample = __builtin_ctz(oversampling);
+    return true;
+}
+
+/**
+ * @brief Connect an event to a task through a PPI channel, via the SoftDevice if it's enabled.
+ * @param channel PPI channel.
+ * @param event Event register.
+ * @param task Task register.
+ */
+static void connectPPI(uint8_t channel, volatile uint32_t *event, volatile uint32_t *task) {
+#ifdef SOFTDEVICE_PRESENT
+    uint8_t sd_enabled = 0;
+    sd_softdevice_is_enabled(&sd_enabled);
+    if (sd_enabled) {
+        sd_ppi_channel_assign(channel, event, task);
+        sd_ppi_channel_enable_set(1UL << channel);
+        return;
+    }
+#endif
+    NRF_PPI->CH[channel].EEP = (uint32_t)event;
+    NRF_PPI->CH[channel].TEP = (uint32_t)task;
+    NRF_PPI->CHENSET = 1UL << channel;
+}
+
+/**
+ * @brief Disable a PPI channel, via the SoftDevice if it's enabled.
+ * @param channel PPI channel.
+ */
+static void disconnectPPI(uint8_t channel) {
+#ifdef SOFTDEVICE_PRESENT
+    uint8_t sd_enabled = 0;
+    sd_softdevice_is_enabled(&sd_enabled);
+    if (sd_enabled) {
+        sd_ppi_channel_enable_clr(1UL << channel);
+        return;
+    }
+#endif
+    NRF_PPI->CHENCLR = 1UL << channel;
+}
+
+/**
+ * @brief Give the SAADC the next block to fill once the current one ends (RESULT.PTR & MAXCNT are double buffered).
+ * @param block Block to fill.
+ */
+static void queueBlock(uint8_t block) {
+    uint32_t samples_left = samples_total - samples_queued;
+    uint16_t length = (samples_left < block_capacity) ? samples_left : block_capacity;
+    NRF_SAADC->RESULT.PTR = (uint32_t)sample_blocks[block];
+    NRF_SAADC->RESULT.MAXCNT = length;
+    block_length[block] = length;
+    samples_queued += length;
+}
+
+/**
+ * @brief Stops the timer, PPI & SAADC, leaving the SAADC disabled ready for analogRead().
+ */
+static void endAcquisition(void) {
+    SAADC_TIMER->TASKS_STOP = 1;
+    disconnectPPI(SAADC_PPI_SAMPLE_CHANNEL);
+    disconnectPPI(SAADC_PPI_RESTART_CHANNEL);
+
+    NRF_SAADC->INTENCLR = SAADC_INTENCLR_END_Msk | SAADC_INTENCLR_STARTED_Msk;
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->TASKS_STOP = 1;
+    while (NRF_SAADC->EVENTS_STOPPED == 0) {
+    }
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    for (uint8_t ch = 0; ch < acquisition.n_channels; ch++) {
+        NRF_SAADC->CH[ch].PSELP = SAADC_CH_PSELP_PSELP_NC;
+    }
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+
+    acquisition_running = false;
+}
+
+/**
+ * @brief Stops the RTC, PPI & SAADC of the limit monitor, leaving the SAADC disabled ready for analogRead().
+ * The monitor set the SAADC's OVERSAMPLE itself, so the ADC settings are forgotten for the next useAdcSettings().
+ */
+static void endLimitMonitor(void) {
+    SAADC_MONITOR_RTC->TASKS_STOP = 1;
+    SAADC_MONITOR_RTC->EVTENCLR = RTC_EVTENCLR_TICK_Msk;
+    disconnectPPI(SAADC_PPI_MONITOR_CHANNEL);
+    disconnectPPI(SAADC_PPI_RESTART_CHANNEL);
+
+    NRF_SAADC->INTENCLR = SAADC_INTENCLR_CH0LIMITH_Msk | SAADC_INTENCLR_CH0LIMITL_Msk;
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->TASKS_STOP = 1;
+    while (NRF_SAADC->EVENTS_STOPPED == 0) {
+    }
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->EVENTS_CH[0].LIMITH = 0;
+    NRF_SAADC->EVENTS_CH[0].LIMITL = 0;
+    NRF_SAADC->CH[0].LIMIT = (INT16_MAX << SAADC_CH_LIMIT_HIGH_Pos) | ((uint16_t)INT16_MIN << SAADC_CH_LIMIT_LOW_Pos);
+    NRF_SAADC->CH[0].PSELP = SAADC_CH_PSELP_PSELP_NC;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+    resetAdcSettings();
+
+    monitor_running = false;
+}
+
+/**
+ * @brief SAADC interrupt of the limit monitor: stops it & calls its handler on the first sample outside the limits.
+ */
+static void handleLimitMonitor(void) {
+    bool above_high = NRF_SAADC->EVENTS_CH[0].LIMITH;
+    bool below_low = NRF_SAADC->EVENTS_CH[0].LIMITL;
+    if (!above_high && !below_low) {
+        return;
+    }
+    endLimitMonitor();
+    monitor.handler(above_high, monitor.context);
+}
+
+extern "C" void SAADC_IRQHandler(void) {
+    if (monitor_running) {
+        handleLimitMonitor();
+        return;
+    }
+
+    // END is handled first: if the ISR was late, the block after it has already STARTED too
+    if (NRF_SAADC->EVENTS_END) {
+        NRF_SAADC->EVENTS_END = 0;
+        uint8_t block = active_block;
+        acquisition.handler(sample_blocks[block], block_length[block], acquisition.context);
+        samples_done += block_length[block];
+        if (finish_requested) {
+            samples_total = samples_done; // the samples of the other block (if any) are dropped
+        }
+
+        if (samples_done >= samples_total) {
+            endAcquisition();
+            BaseType_t higher_priority_task_woken = pdFALSE;
+            xSemaphoreGiveFromISR(acquisition_done, &higher_priority_task_woken);
+            portYIELD_FROM_ISR(higher_priority_task_woken);
+            return;
+        }
+    }
+
+    if (NRF_SAADC->EVENTS_STARTED) {
+        NRF_SAADC->EVENTS_STARTED = 0;
+        // the queued block has started, queue the one just handled or stop restarting after this one
+        active_block ^= 1;
+        if (samples_queued < samples_total) {
+            queueBlock(active_block ^ 1);
+        } else {
+            disconnectPPI(SAADC_PPI_RESTART_CHANNEL);
+        }
+    }
+}
+
+/**
+ * @brief Checks the channels of an acquisition are analog inputs with analog references the SAADC has.
+ * @param config Settings of the acquisition.
+ * @return True if they are.
+ */
+static bool saadcChannelsSupported(const adcAcquisitionConfig *config) {
+    if ((config->n_channels == 0) || (config->n_channels > ADC_MAX_SCAN_CHANNELS)) {
+        return false;
+    }
+    uint32_t unused;
+    for (uint8_t ch = 0; ch < config->n_channels; ch++) {
+        if ((saadcInput(config->channels[ch].pin) == SAADC_CH_PSELP_PSELP_NC) ||
+            !saadcGainReference(config->channels[ch].analog_ref, &unused)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool adcAcquisitionSupported(const adcAcquisitionConfig *config) {
+    uint32_t unused;
+    return saadcChannelsSupported(config) && saadcResolution(config->analog_resolution, &unused) &&
+           saadcOversample(config->oversampling, &unused);
+}
+
+uint32_t adcAcquisitionSampleRate(const adcAcquisitionConfig *config) {
+    // oversampled conversions are done in a burst for each channel, and the scan has to finish before the next
+    uint32_t conversions = ((config->oversampling > 1) ? config->oversampling : 1) * config->n_channels;
+    uint32_t max_sample_rate = 1000000UL / ((conversions * ADC_CONVERSION_US) + 1);
+    if ((config->sample_rate_hz == 0) || (config->sample_rate_hz > max_sample_rate)) {
+        return max_sample_rate;
+    }
+    return config->sample_rate_hz;
+}
+
+bool startAdcAcquisition(const adcAcquisitionConfig *config) {
+    if (acquisition_running || monitor_running) {
+        log(LOG_LEVEL::WARN, "ADC acquisition or limit monitor already running.");
+        return false;
+    }
+    uint32_t resolution, oversample;
+    if ((config->n_samples == 0) || (config->handler == nullptr) || !saadcChannelsSupported(config) ||
+        !saadcResolution(config->analog_resolution, &resolution) ||
+        !saadcOversample(config->oversampling, &oversample)) {
+        log(LOG_LEVEL::WARN, "ADC acquisition settings not supported.");
+        return false;
+    }
+
+    if (acquisition_done == NULL) {
+        acquisition_done = xSemaphoreCreateBinary();
+    }
+    xSemaphoreTake(acquisition_done, 0); // in case the last acquisition finished without being waited for
+
+    acquisition = *config;
+    active_block = 0;
+    samples_total = config->n_samples * config->n_channels;
+    block_capacity = (ADC_BLOCK_SAMPLES / config->n_channels) * config->n_channels;
+    samples_queued = 0;
+    samples_done = 0;
+    finish_requested = false;
+
+    // SAADC: every channel sampled in turn (a scan) on each SAMPLE task, oversampled conversions done in a burst
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        NRF_SAADC->CH[ch].PSELP = SAADC_CH_PSELP_PSELP_NC;
+        NRF_SAADC->CH[ch].PSELN = SAADC_CH_PSELN_PSELN_NC;
+    }
+    NRF_SAADC->RESOLUTION = resolution;
+    NRF_SAADC->OVERSAMPLE = oversample;
+    NRF_SAADC->SAMPLERATE = SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    for (uint8_t ch = 0; ch < config->n_channels; ch++) {
+        uint32_t gain_reference;
+        saadcGainReference(config->channels[ch].analog_ref, &gain_reference);
+        NRF_SAADC->CH[ch].CONFIG =
+            ((SAADC_CH_CONFIG_RESP_Bypass << SAADC_CH_CONFIG_RESP_Pos) & SAADC_CH_CONFIG_RESP_Msk) |
+            ((SAADC_CH_CONFIG_RESN_Bypass << SAADC_CH_CONFIG_RESN_Pos) & SAADC_CH_CONFIG_RESN_Msk) | gain_reference |
+            ((SAADC_CH_CONFIG_TACQ_3us << SAADC_CH_CONFIG_TACQ_Pos) & SAADC_CH_CONFIG_TACQ_Msk) |
+            ((SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos) & SAADC_CH_CONFIG_MODE_Msk) |
+            (((oversample == SAADC_OVERSAMPLE_OVERSAMPLE_Bypass) ? SAADC_CH_CONFIG_BURST_Disabled
+                                                                 : SAADC_CH_CONFIG_BURST_Enabled)
+             << SAADC_CH_CONFIG_BURST_Pos);
+        NRF_SAADC->CH[ch].PSELP = saadcInput(config->channels[ch].pin);
+    }
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos;
+
+    // start on the first block, then queue the second
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    queueBlock(0);
+    NRF_SAADC->TASKS_START = 1;
+    while (NRF_SAADC->EVENTS_STARTED == 0) {
+    }
+    NRF_SAADC->EVENTS_STARTED = 0;
+    if (samples_queued < samples_total) {
+        queueBlock(1);
+        connectPPI(SAADC_PPI_RESTART_CHANNEL, &NRF_SAADC->EVENTS_END, &NRF_SAADC->TASKS_START);
+    }
+
+    NRF_SAADC->INTENSET = SAADC_INTENSET_END_Msk | SAADC_INTENSET_STARTED_Msk;
+    NVIC_SetPriority(SAADC_IRQn, SAADC_IRQ_PRIORITY);
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+    NVIC_EnableIRQ(SAADC_IRQn);
+
+    // timer: 16MHz, COMPARE[0] each sample period
+    SAADC_TIMER->TASKS_STOP = 1;
+    SAADC_TIMER->TASKS_CLEAR = 1;
+    SAADC_TIMER->MODE = TIMER_MODE_MODE_Timer << TIMER_MODE_MODE_Pos;
+    SAADC_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
+    SAADC_TIMER->PRESCALER = 0;
+    SAADC_TIMER->CC[0] = 16000000UL / adcAcquisitionSampleRate(config);
+    SAADC_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_CLEAR_Enabled << TIMER_SHORTS_COMPARE0_CLEAR_Pos;
+    SAADC_TIMER->EVENTS_COMPARE[0] = 0;
+    connectPPI(SAADC_PPI_SAMPLE_CHANNEL, &SAADC_TIMER->EVENTS_COMPARE[0], &NRF_SAADC->TASKS_SAMPLE);
+
+    acquisition_running = true;
+    SAADC_TIMER->TASKS_START = 1;
+
+    log(LOG_LEVEL::DEBUG, "ADC acquisition of %lu samples of %d channel(s) at %lu Hz started.", acquisition.n_samples,
+        acquisition.n_channels, adcAcquisitionSampleRate(config));
+    return true;
+}
+
+bool isAdcAcquisitionDone(void) {
+    return !acquisition_running;
+}
+
+bool waitForAdcAcquisition(uint32_t timeout_ms) {
+    if (acquisition_running && (xSemaphoreTake(acquisition_done, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)) {
+        log(LOG_LEVEL::WARN, "ADC acquisition timed out after %lu of %lu samples.", samples_done, samples_total);
+        stopAdcAcquisition();
+        return false;
+    }
+    return samples_done >= samples_total;
+}
+
+void stopAdcAcquisition(void) {
+    NVIC_DisableIRQ(SAADC_IRQn);
+    if (acquisition_running) {
+        endAcquisition();
+    }
+    NVIC_EnableIRQ(SAADC_IRQn);
+}
+
+void finishAdcAcquisition(void) {
+    finish_requested = true;
+}
+
+bool startAdcLimitMonitor(const adcLimitConfig *config) {
+    if (acquisition_running || monitor_running) {
+        log(LOG_LEVEL::WARN, "ADC acquisition or limit monitor already running.");
+        return false;
+    }
+    uint32_t gain_reference, resolution, oversample;
+    if ((config->handler == nullptr) || (config->low_limit > config->high_limit) ||
+        (config->sample_interval_ms == 0) || (config->sample_interval_ms > ADC_MONITOR_MAX_INTERVAL_MS) ||
+        (saadcInput(config->channel.pin) == SAADC_CH_PSELP_PSELP_NC) ||
+        !saadcGainReference(config->channel.analog_ref, &gain_reference) ||
+        !saadcResolution(config->analog_resolution, &resolution) ||
+        !saadcOversample(config->oversampling, &oversample)) {
+        log(LOG_LEVEL::WARN, "ADC limit monitor settings not supported.");
+        return false;
+    }
+    monitor = *config;
+
+    // SAADC: a single channel, its result overwritten by every sample as only the limit events matter
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        NRF_SAADC->CH[ch].PSELP = SAADC_CH_PSELP_PSELP_NC;
+        NRF_SAADC->CH[ch].PSELN = SAADC_CH_PSELN_PSELN_NC;
+    }
+    NRF_SAADC->RESOLUTION = resolution;
+    NRF_SAADC->OVERSAMPLE = oversample;
+    NRF_SAADC->SAMPLERATE = SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    NRF_SAADC->CH[0].CONFIG =
+        ((SAADC_CH_CONFIG_RESP_Bypass << SAADC_CH_CONFIG_RESP_Pos) & SAADC_CH_CONFIG_RESP_Msk) |
+        ((SAADC_CH_CONFIG_RESN_Bypass << SAADC_CH_CONFIG_RESN_Pos) & SAADC_CH_CONFIG_RESN_Msk) | gain_reference |
+        ((SAADC_CH_CONFIG_TACQ_3us << SAADC_CH_CONFIG_TACQ_Pos) & SAADC_CH_CONFIG_TACQ_Msk) |
+        ((SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos) & SAADC_CH_CONFIG_MODE_Msk) |
+        (((oversample == SAADC_OVERSAMPLE_OVERSAMPLE_Bypass) ? SAADC_CH_CONFIG_BURST_Disabled
+                                                             : SAADC_CH_CONFIG_BURST_Enabled)
+         << SAADC_CH_CONFIG_BURST_Pos);
+    NRF_SAADC->CH[0].LIMIT = ((uint32_t)(uint16_t)config->high_limit << SAADC_CH_LIMIT_HIGH_Pos) |
+                             ((uint32_t)(uint16_t)config->low_limit << SAADC_CH_LIMIT_LOW_Pos);
+    NRF_SAADC->CH[0].PSELP = saadcInput(config->channel.pin);
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos;
+
+    NRF_SAADC->RESULT.PTR = (uint32_t)&monitor_result;
+    NRF_SAADC->RESULT.MAXCNT = 1;
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->EVENTS_CH[0].LIMITH = 0;
+    NRF_SAADC->EVENTS_CH[0].LIMITL = 0;
+    NRF_SAADC->TASKS_START = 1;
+    while (NRF_SAADC->EVENTS_STARTED == 0) {
+    }
+    NRF_SAADC->EVENTS_STARTED = 0;
+    // each sample fills the buffer, so restart on it straight away ready for the next sample
+    connectPPI(SAADC_PPI_RESTART_CHANNEL, &NRF_SAADC->EVENTS_END, &NRF_SAADC->TASKS_START);
+
+    NRF_SAADC->INTENSET = SAADC_INTENSET_CH0LIMITH_Msk | SAADC_INTENSET_CH0LIMITL_Msk;
+    NVIC_SetPriority(SAADC_IRQn, SAADC_IRQ_PRIORITY);
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+    NVIC_EnableIRQ(SAADC_IRQn);
+
+    // RTC: TICK every sample interval, from the low frequency clock that keeps running while the CPU sleeps
+    uint32_t prescaler = ((32768UL * config->sample_interval_ms) / 1000) - 1;
+    SAADC_MONITOR_RTC->TASKS_STOP = 1;
+    SAADC_MONITOR_RTC->TASKS_CLEAR = 1;
+    SAADC_MONITOR_RTC->PRESCALER = (prescaler < RTC_PRESCALER_PRESCALER_Msk) ? prescaler : RTC_PRESCALER_PRESCALER_Msk;
+    SAADC_MONITOR_RTC->EVENTS_TICK = 0;
+    SAADC_MONITOR_RTC->EVTENSET = RTC_EVTENSET_TICK_Msk;
+    connectPPI(SAADC_PPI_MONITOR_CHANNEL, &SAADC_MONITOR_RTC->EVENTS_TICK, &NRF_SAADC->TASKS_SAMPLE);
+
+    monitor_running = true;
+    SAADC_MONITOR_RTC->TASKS_START = 1;
+
+    log(LOG_LEVEL::DEBUG, "ADC limit monitor started: %d to %d every %lu ms.", config->low_limit, config->high_limit,
+        config->sample_interval_ms);
+    return true;
+}
+
+void stopAdcLimitMonitor(void) {
+    NVIC_DisableIRQ(SAADC_IRQn);
+    if (monitor_running) {
+        endLimitMonitor();
+    }
+    NVIC_EnableIRQ(SAADC_IRQn);
+}
+
+bool isAdcLimitMonitorRunning(void) {
+    return monitor_running;
+}
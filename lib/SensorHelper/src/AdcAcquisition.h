@@ -0,0 +1,159 @@
+#ifndef ADC_ACQUISITION_H
+#define ADC_ACQUISITION_H
+
+/**
+ * @file AdcAcquisition.h
+ * @author Kalina Knight
+ * @brief Background acquisition of a block of ADC samples using the nRF52 SAADC with EasyDMA.
+ * A hardware timer (SAADC_TIMER) triggers each sample through PPI, and the SAADC writes the results into one of two
+ * sample blocks while the other is handed to a block handler. The SAADC END event restarts it on the next block (also
+ * through PPI), so no samples are missed and the CPU only wakes up once per block. The calling task sleeps on a
+ * semaphore until the whole acquisition is done.
+ *
+ * Several analog inputs can be sampled together in one scan: each sample converts every channel in turn (each with
+ * its own gain & reference), and the results land in the same block interleaved.
+ *
+ * Only one acquisition can run at a time, and analogRead() must not be called until it is done.
+ *
+ * The SAADC can instead watch an analog input while the CPU sleeps (a limit monitor): an RTC on the 32.768kHz clock
+ * triggers a sample every few ms through PPI, and the SAADC's own limit comparators only wake the CPU (once) when a
+ * sample is outside the limits. No acquisition can run while it is watching.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+
+#include "Logging.h"
+
+#define ADC_BLOCK_SAMPLES 128       /**< Samples per DMA block, two blocks are used. */
+#define ADC_CONVERSION_US 5         /**< Time of a single conversion: 3us acquisition (as analogRead()) + 2us. */
+#define ADC_TIMEOUT_MARGIN_MS 50    /**< Added to the expected time of an acquisition before giving up on it. */
+#define ADC_MAX_SCAN_CHANNELS 4     /**< Most analog inputs sampled together in one scan. */
+
+#define SAADC_TIMER NRF_TIMER3      /**< Timer that paces the samples, TIMER0 belongs to the SoftDevice. */
+#define SAADC_PPI_SAMPLE_CHANNEL 7  /**< PPI channel: SAADC_TIMER COMPARE[0] -> SAADC SAMPLE. */
+#define SAADC_PPI_RESTART_CHANNEL 8 /**< PPI channel: SAADC END -> SAADC START (on the next block). */
+#define SAADC_IRQ_PRIORITY 6        /**< Low app priority, so FreeRTOS & SoftDevice calls are allowed. */
+
+#define SAADC_MONITOR_RTC NRF_RTC2      /**< Paces the limit monitor, RTC0 & RTC1 are the SoftDevice's & FreeRTOS'. */
+#define SAADC_PPI_MONITOR_CHANNEL 9     /**< PPI channel: SAADC_MONITOR_RTC TICK -> SAADC SAMPLE. */
+#define ADC_MONITOR_MAX_INTERVAL_MS 125 /**< Longest time between limit monitor samples, the RTC's largest prescaler. */
+
+/**
+ * @brief Called with each completed block of raw samples, from the SAADC interrupt so it must be quick.
+ * The block is reused once the handler returns.
+ * @param samples Raw samples, can be slightly negative near 0V (analogRead() clamps these to 0). With several channels
+ * they are interleaved: channel c of scan s is samples[s * n_channels + c], and every block holds whole scans.
+ * @param n_samples Number of samples in the block, of every channel.
+ * @param context Context given with the acquisition.
+ */
+typedef void (*adcBlockHandler)(const int16_t *samples, uint16_t n_samples, void *context);
+
+/**
+ * @brief Called when a sample of the limit monitor is outside its limits, from the SAADC interrupt so it must be quick.
+ * The monitor has already stopped by then.
+ * @param above_high True if the sample was above the high limit, false if below the low limit.
+ * @param context Context given with the monitor.
+ */
+typedef void (*adcLimitHandler)(bool above_high, void *context);
+
+/** @brief An analog input of an acquisition. */
+struct adcChannel {
+    uint8_t pin;                  /**< Analog pin to sample. */
+    _eAnalogReference analog_ref; /**< ADC analog reference, i.e. the gain & reference of this channel. */
+};
+
+/** @brief Settings of an acquisition. */
+struct adcAcquisitionConfig {
+    adcChannel channels[ADC_MAX_SCAN_CHANNELS]; /**< Analog inputs, all sampled (in order) by each scan. */
+    uint8_t n_channels;                         /**< Number of channels, 1 for a single analog input. */
+    int analog_resolution;   /**< ADC resolution of every channel, 8, 10, 12 or 14 bits. */
+    uint32_t oversampling;   /**< Conversions averaged into each sample (a power of 2 up to 256), 0 to disable. */
+    uint32_t n_samples;      /**< Samples to acquire of each channel, i.e. scans. */
+    uint32_t sample_rate_hz; /**< Scans per second, 0 for as fast as the oversampling allows. */
+    adcBlockHandler handler; /**< Called with each completed block. */
+    void *context;           /**< Passed to the handler. */
+};
+
+/** @brief Settings of a limit monitor. */
+struct adcLimitConfig {
+    adcChannel channel;          /**< Analog input to watch. */
+    int analog_resolution;       /**< ADC resolution, 8, 10, 12 or 14 bits. */
+    uint32_t oversampling;       /**< Conversions averaged into each sample (a power of 2 up to 256), 0 to disable. */
+    uint32_t sample_interval_ms; /**< Time between samples, up to ADC_MONITOR_MAX_INTERVAL_MS. */
+    int16_t low_limit;           /**< Raw samples below this wake the CPU, INT16_MIN to never. */
+    int16_t high_limit;          /**< Raw samples above this wake the CPU, INT16_MAX to never. */
+    adcLimitHandler handler;     /**< Called when a sample is outside the limits. */
+    void *context;               /**< Passed to the handler. */
+};
+
+/**
+ * @brief Checks the SAADC can do an acquisition with these settings.
+ * The pins must be analog inputs, and the analog references & resolution ones the SAADC has.
+ * @param config Settings of the acquisition.
+ * @return True if it can.
+ */
+bool adcAcquisitionSupported(const adcAcquisitionConfig *config);
+
+/**
+ * @brief Get the sample rate an acquisition will actually run at.
+ * @param config Settings of the acquisition.
+ * @return Sample (scan) rate [Hz], limited by the time the oversampled conversions of every channel take.
+ */
+uint32_t adcAcquisitionSampleRate(const adcAcquisitionConfig *config);
+
+/**
+ * @brief Starts an acquisition in the background, returning straight away.
+ * @param config Settings of the acquisition, copied.
+ * @return True if started, false if the settings aren't supported or an acquisition is already running.
+ */
+bool startAdcAcquisition(const adcAcquisitionConfig *config);
+
+/**
+ * @brief Checks if the last acquisition is done.
+ * @return True if done (or none were started).
+ */
+bool isAdcAcquisitionDone(void);
+
+/**
+ * @brief Sleeps until the acquisition is done, stopping it if it takes too long.
+ * @param timeout_ms Time to wait [ms].
+ * @return True if every sample was acquired, false if it timed out.
+ */
+bool waitForAdcAcquisition(uint32_t timeout_ms);
+
+/**
+ * @brief Stops the acquisition, any samples in the current block are lost.
+ */
+void stopAdcAcquisition(void);
+
+/**
+ * @brief Ends the acquisition early once the block being handled is done, e.g. when enough samples have been taken.
+ * Only to be called from a block handler. waitForAdcAcquisition() then returns true as if every sample was acquired.
+ */
+void finishAdcAcquisition(void);
+
+/**
+ * @brief Starts watching an analog input in the background, returning straight away.
+ * Stops by itself (calling the handler) the first time a sample is outside the limits.
+ * @param config Settings of the monitor, copied.
+ * @return True if started, false if the settings aren't supported or an acquisition or monitor is already running.
+ */
+bool startAdcLimitMonitor(const adcLimitConfig *config);
+
+/**
+ * @brief Stops the limit monitor, if it's running, leaving the SAADC disabled ready for analogRead().
+ */
+void stopAdcLimitMonitor(void);
+
+/**
+ * @brief Checks if the limit monitor is running.
+ * @return True if it's watching its analog input.
+ */
+bool isAdcLimitMonitorRunning(void);
+
+#endif // ADC_ACQUISITION_H
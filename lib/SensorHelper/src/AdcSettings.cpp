@@ -0,0 +1,28 @@
+#include "AdcSettings.h"
+
+static adcSettings current_settings = {};  /**< Settings the ADC is using. */
+static bool current_settings_known = false; /**< False until useAdcSettings() has set them. */
+
+bool useAdcSettings(const adcSettings *settings) {
+    if (current_settings_known && (settings->analog_ref == current_settings.analog_ref) &&
+        (settings->analog_resolution == current_settings.analog_resolution) &&
+        (settings->oversampling == current_settings.oversampling)) {
+        return false;
+    }
+
+    analogReference(settings->analog_ref);
+    analogReadResolution(settings->analog_resolution);
+    analogOversampling(settings->oversampling);
+    current_settings = *settings;
+    current_settings_known = true;
+    log(LOG_LEVEL::DEBUG, "ADC settings changed: reference %d | %d-bit | oversampling %lu", settings->analog_ref,
+        settings->analog_resolution, settings->oversampling);
+
+    // Let the ADC settle
+    delay(ADC_SETTLE_MS);
+    return true;
+}
+
+void resetAdcSettings(void) {
+    current_settings_known = false;
+}
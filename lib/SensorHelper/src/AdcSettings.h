@@ -0,0 +1,45 @@
+#ifndef ADC_SETTINGS_H
+#define ADC_SETTINGS_H
+
+/**
+ * @file AdcSettings.h
+ * @author Kalina Knight
+ * @brief Keeps track of the settings the ADC is using, so they are only changed (and the ADC only left to settle)
+ * when they are actually different.
+ * The analog reference, resolution & oversampling are shared by every analog pin, so every AnalogSensor asks for its
+ * settings with useAdcSettings() before sampling. Reading several sensors with the same settings back to back then
+ * costs nothing, and a sensor with different settings still gets them (and the settling time) when it takes over.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+
+#include "Logging.h"
+
+#define ADC_SETTLE_MS 1 /**< Time to let the ADC settle after its settings change. */
+
+/** @brief Settings of the ADC shared by every analog pin. */
+struct adcSettings {
+    _eAnalogReference analog_ref; /**< ADC analog reference. */
+    int analog_resolution;        /**< ADC resolution. */
+    uint32_t oversampling;        /**< ADC oversampling setting. */
+};
+
+/**
+ * @brief Gives the ADC these settings and lets it settle, unless it already has them.
+ * @param settings Settings to use.
+ * @return True if the settings were changed, false if the ADC already had them.
+ */
+bool useAdcSettings(const adcSettings *settings);
+
+/**
+ * @brief Forgets the settings the ADC is using, so the next useAdcSettings() applies its settings whatever they are.
+ * Needed if the ADC settings are changed without useAdcSettings(), e.g. by calling analogReference() directly.
+ */
+void resetAdcSettings(void);
+
+#endif // ADC_SETTINGS_H
@@ -27,24 +27,196 @@ void AnalogSensor::setCompensationFactor(float comp_factor) {
     setRealMVPerLSB();
 };
 
-float AnalogSensor::getSensorMV(void) {
-    // set the ADC params each time in case the adc is being used for multiple sensors
-    analogReference(analog_ref);
-    analogReadResolution(analog_resolution);
-    analogOversampling(oversampling);
-
-    // Let the ADC settle
-    delay(1);
+float AnalogSensor::getSensorMV(uint32_t n_samples) {
+    // Get the raw ADC reading(s), converting only their average
+    adcSampleSums sums;
+    sampleRaw(n_samples, &sums);
+    return sumsToMV(&sums);
+}
 
-    // Get a raw ADC reading
-    float sensor_mv = readMV();
+float AnalogSensor::sumsToMV(const adcSampleSums *sums) {
+    float sensor_mv = sums->mean() * real_MV_per_LSB;
 
     log(LOG_LEVEL::DEBUG, "ADC: %.2f mV", sensor_mv);
 
     return sensor_mv;
 }
 
+void adcSampleSums::addBlock(const int16_t *samples, uint16_t n, uint8_t stride) {
+    // a block's sum fits in 32 bits, its sum of squares doesn't
+    uint32_t block_sum = 0;
+    uint64_t block_sum_squares = 0;
+    uint16_t block_min = min_raw;
+    uint16_t block_max = max_raw;
+    uint16_t block_samples = 0;
+    for (uint16_t i = 0; i < n; i += stride, block_samples++) {
+        uint16_t raw = (samples[i] > 0) ? samples[i] : 0;
+        block_sum += raw;
+        block_sum_squares += (uint32_t)raw * raw;
+        block_min = (raw < block_min) ? raw : block_min;
+        block_max = (raw > block_max) ? raw : block_max;
+    }
+    n_samples += block_samples;
+    sum += block_sum;
+    sum_squares += block_sum_squares;
+    min_raw = block_min;
+    max_raw = block_max;
+}
+
+/**
+ * @brief adcBlockHandler that adds each block to the adcSampleSums context.
+ */
+static void addSampleBlock(const int16_t *samples, uint16_t n_samples, void *context) {
+    ((adcSampleSums *)context)->addBlock(samples, n_samples);
+}
+
+/** @brief Context of addScanBlock(). */
+struct scanSums {
+    adcSampleSums *sums; /**< Sums of each channel. */
+    uint8_t n_channels;
+    harmonicAnalysis *harmonics; /**< Harmonic analysis of channel 0, or nullptr. */
+};
+
+/**
+ * @brief adcBlockHandler that adds each channel of a block of scans to its adcSampleSums, of the scanSums context.
+ */
+static void addScanBlock(const int16_t *samples, uint16_t n_samples, void *context) {
+    scanSums *scan = (scanSums *)context;
+    for (uint8_t ch = 0; ch < scan->n_channels; ch++) {
+        scan->sums[ch].addBlock(&samples[ch], n_samples - ch, scan->n_channels);
+    }
+    if (scan->harmonics != nullptr) {
+        scan->harmonics->addBlock(samples, n_samples, scan->n_channels);
+    }
+}
+
+bool AnalogSensor::sampleScanGroup(const analogScanGroup *group, adcSampleSums *sums) {
+    if ((group->n_sensors == 0) || (group->n_sensors > ADC_MAX_SCAN_CHANNELS)) {
+        return false;
+    }
+    AnalogSensor *first = group->sensors[0];
+    scanSums scan = { sums, group->n_sensors, group->harmonics };
+    adcAcquisitionConfig config = first->acquisitionConfig(group->n_samples, addScanBlock, &scan);
+    config.n_channels = group->n_sensors;
+    config.sample_rate_hz = group->sample_rate_hz;
+    config.oversampling = (group->oversampling != 0) ? group->oversampling : first->oversampling;
+    for (uint8_t i = 0; i < group->n_sensors; i++) {
+        // the resolution is shared by every channel of the SAADC, the gain & reference aren't
+        if (group->sensors[i]->analog_resolution != first->analog_resolution) {
+            log(LOG_LEVEL::WARN, "Analog sensors with different resolutions can't be scanned together.");
+            return false;
+        }
+        config.channels[i] = { group->sensors[i]->pin, group->sensors[i]->analog_ref };
+        sums[i] = adcSampleSums();
+    }
+
+    if (!first->acquireSamples(&config) || !first->waitForSamples()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < group->n_sensors; i++) {
+        group->sensors[i]->rawADC = sums[i].mean();
+    }
+    return true;
+}
+
+void AnalogSensor::sampleRaw(uint32_t n_samples, adcSampleSums *sums) {
+    *sums = adcSampleSums();
+    useADC();
+    if ((n_samples >= ADC_ACQUISITION_MIN_SAMPLES) && acquireSamples(n_samples, addSampleBlock, sums)) {
+        if (waitForSamples()) {
+            return;
+        }
+        *sums = adcSampleSums();
+    }
+
+    for (uint32_t i = 0; i < n_samples; i++) {
+        uint32_t raw = analogRead(pin);
+        sums->add(raw);
+        rawADC = raw;
+    }
+}
+
+/** @brief Context of addConvergingBlock(). */
+struct convergingSums {
+    adcSampleSums *sums;
+    const adcConvergence *convergence;
+};
+
+/**
+ * @brief adcBlockHandler that adds each block to the convergingSums context, finishing the acquisition once the mean
+ * has converged.
+ */
+static void addConvergingBlock(const int16_t *samples, uint16_t n_samples, void *context) {
+    convergingSums *converging = (convergingSums *)context;
+    adcSampleSums *sums = converging->sums;
+    sums->addBlock(samples, n_samples);
+    if ((sums->n_samples >= converging->convergence->min_samples) &&
+        sums->meanConverged(converging->convergence->tolerance_raw, converging->convergence->z)) {
+        finishAdcAcquisition();
+    }
+}
+
+void AnalogSensor::sampleRawUntil(const adcConvergence *convergence, adcSampleSums *sums) {
+    *sums = adcSampleSums();
+    useADC();
+    convergingSums converging = { sums, convergence };
+    if ((convergence->max_samples >= ADC_ACQUISITION_MIN_SAMPLES) &&
+        acquireSamples(convergence->max_samples, addConvergingBlock, &converging)) {
+        if (waitForSamples()) {
+            return;
+        }
+        *sums = adcSampleSums();
+    }
+
+    for (uint32_t i = 0; i < convergence->max_samples; i++) {
+        uint32_t raw = analogRead(pin);
+        sums->add(raw);
+        rawADC = raw;
+        if ((sums->n_samples >= convergence->min_samples) &&
+            sums->meanConverged(convergence->tolerance_raw, convergence->z)) {
+            break;
+        }
+    }
+}
+
+bool AnalogSensor::acquireSamples(uint32_t n_samples, adcBlockHandler handler, void *context,
+                                  uint32_t sample_rate_hz) {
+    adcAcquisitionConfig config = acquisitionConfig(n_samples, handler, context);
+    config.sample_rate_hz = sample_rate_hz;
+    return acquireSamples(&config);
+}
+
+bool AnalogSensor::acquireSamples(const adcAcquisitionConfig *config) {
+    // the acquisition sets up the SAADC itself, but it still needs to settle if the settings changed
+    adcSettings settings = { config->channels[0].analog_ref, config->analog_resolution, config->oversampling };
+    useAdcSettings(&settings);
+    if (!startAdcAcquisition(config)) {
+        return false;
+    }
+    acquisition_timeout_ms =
+        (uint32_t)(((uint64_t)config->n_samples * 1000) / adcAcquisitionSampleRate(config)) + ADC_TIMEOUT_MARGIN_MS;
+    return true;
+}
+
+adcAcquisitionConfig AnalogSensor::acquisitionConfig(uint32_t n_samples, adcBlockHandler handler,
+                                                     void *context) const {
+    adcAcquisitionConfig config = {};
+    config.channels[0] = { pin, analog_ref };
+    config.n_channels = 1;
+    config.analog_resolution = analog_resolution;
+    config.oversampling = oversampling;
+    config.n_samples = n_samples;
+    config.handler = handler;
+    config.context = context;
+    return config;
+}
+
+bool AnalogSensor::waitForSamples(void) {
+    return waitForAdcAcquisition(acquisition_timeout_ms);
+}
+
 float AnalogSensor::readMV(void) {
+    useADC();
     // Get the raw ADC value
     rawADC = analogRead(pin);
 
@@ -54,6 +226,12 @@ float AnalogSensor::readMV(void) {
     return (rawADC * real_MV_per_LSB);
 }
 
+void AnalogSensor::useADC(void) {
+    // the ADC is shared by every sensor, so its settings are only changed if a sensor with different ones used it last
+    adcSettings settings = { analog_ref, analog_resolution, oversampling };
+    useAdcSettings(&settings);
+}
+
 void AnalogSensor::setRealMVPerLSB() {
     float adc_analog_ref_mv = 0;
 
@@ -178,44 +356,196 @@ void CurrentSensor::ADCInit(uint8_t pin_mode) {
 
 // Calibrates sensor to remove the zero offset
  void CurrentSensor::zeroCurrentOffsetCalibration() {
-    // For number of samples creates a sum of current sensor mv value
-    for (int i = 0; i < numberOfSamples; i++)                                                               
-        {
-        current_sensor_mV = readMV();  // mV offset 
-        current_sensor_mV_sum = current_sensor_mV_sum + current_sensor_mV;                                      
-        }
-    
-    current_sample_mv = current_sensor_mV_sum/numberOfSamples;
+    // For number of samples creates a sum of the raw current sensor values
+    adcSampleSums sums;
+    sampleRaw(numberOfSamples, &sums);
+    float current_sample_mv = sums.mean() * real_MV_per_LSB;
 
     log(LOG_LEVEL::DEBUG, "Current sample mv = %.2f%% mV", current_sample_mv);
 
-    zeroCurrentOffset = 2500 - current_sample_mv; 
-    current_sensor_mV_sum = 0;
+    zeroCurrentOffset = CURRENT_SENSOR_ZERO_MV - current_sample_mv;
+    calibratedZeroOffset = zeroCurrentOffset;
 
     log(LOG_LEVEL::DEBUG, "Zero current offset = %.2f%% mV", zeroCurrentOffset);
+
+    currentCalibration calibration = {};
+    calibration.zero_offset_mv = zeroCurrentOffset;
+    calibration.compensation_factor = compensation_factor;
+    calibration.boots = 0;
+    saveCurrentCalibration(&calibration);
  }
 
+bool CurrentSensor::restoreZeroCurrentCalibration(void) {
+    currentCalibration calibration;
+    if (!loadCurrentCalibration(&calibration)) {
+        return false;
+    }
+    if (calibration.compensation_factor != compensation_factor) {
+        log(LOG_LEVEL::INFO, "Saved current calibration is for a different compensation factor.");
+        return false;
+    }
+    if (calibration.boots >= CURRENT_CALIBRATION_MAX_BOOTS) {
+        log(LOG_LEVEL::INFO, "Saved current calibration is stale (%lu boots old).", calibration.boots);
+        return false;
+    }
+
+    zeroCurrentOffset = calibration.zero_offset_mv;
+    calibratedZeroOffset = zeroCurrentOffset;
+    calibration.boots++;
+    saveCurrentCalibration(&calibration);
+    log(LOG_LEVEL::INFO, "Zero current offset of %.2f mV reloaded (%lu boots old).", zeroCurrentOffset,
+        calibration.boots);
+    return true;
+}
+
+float CurrentSensor::rawToAmp(float raw) {
+    float current_sensor_mV = (raw * real_MV_per_LSB) + zeroCurrentOffset; // mV offset
+    return (current_sensor_mV - CURRENT_SENSOR_ZERO_MV) * CURRENT_SENSOR_A_PER_MV;
+}
+
+float CurrentSensor::ampToRaw(float amp) {
+    float current_sensor_mV = (amp / CURRENT_SENSOR_A_PER_MV) + CURRENT_SENSOR_ZERO_MV;
+    return (current_sensor_mV - zeroCurrentOffset) / real_MV_per_LSB;
+}
+
+bool CurrentSensor::startEventMonitor(adcLimitHandler handler, void *context) {
+    adcLimitConfig config = {};
+    config.channel = { pin, analog_ref };
+    config.analog_resolution = analog_resolution;
+    config.oversampling = EVENT_OVERSAMPLING;
+    config.sample_interval_ms = EVENT_SAMPLE_INTERVAL_MS;
+    // thresholds outside of the ADC's range are never crossed
+    config.low_limit = constrain(lroundf(ampToRaw(event_low_A)), INT16_MIN, INT16_MAX);
+    config.high_limit = constrain(lroundf(ampToRaw(event_high_A)), INT16_MIN, INT16_MAX);
+    config.handler = handler;
+    config.context = context;
+    if (!startAdcLimitMonitor(&config)) {
+        return false;
+    }
+    log(LOG_LEVEL::DEBUG, "Watching for current events below %.2f A or above %.2f A.", event_low_A, event_high_A);
+    return true;
+}
 
 float CurrentSensor::readCurrentAmp() {
+    // sum the raw samples, converting only their average
+    adcSampleSums sums;
+    if (adaptive_sampling) {
+        // stop once the mean current is known well enough
+        adcConvergence convergence = { adaptive_min_samples, (uint32_t)numberOfSamples,
+                                       adaptive_tolerance_A / (real_MV_per_LSB * CURRENT_SENSOR_A_PER_MV),
+                                       ADAPTIVE_CONFIDENCE_Z };
+        sampleRawUntil(&convergence, &sums);
+    } else {
+        sampleRaw(numberOfSamples, &sums);
+    }
+    samples_used = sums.n_samples;
+    log(LOG_LEVEL::DEBUG, "Current sensor: %lu samples (RMS noise %.2f LSB)", samples_used, sums.acRms());
+    return sumsToAmp(&sums);
+}
+
+float CurrentSensor::sumsToAmp(const adcSampleSums *sums) {
+    ADCaverage = sums->mean();
+    currentSample = rawToAmp(ADCaverage);
+    trackZeroDrift(sums, false);
 
-    // analogReference(analog_ref);
-    // analogReadResolution(analog_resolution);
-    // analogOversampling(oversampling);
-
-       for (int i = 0; i < numberOfSamples; i++)                                                               
-          {
-            current_sensor_mV = readMV() + zeroCurrentOffset;  // mV offset 
-            currentSensorADCvalSum = rawADC + currentSensorADCvalSum;
-            currentSampleRead = (current_sensor_mV - 2500)*0.032; // 0.032; // 625 mV / 20 A = 31.25, 1/31.25 = 0.032
-            currentSampleSum = currentSampleSum + currentSampleRead ;                                      
-          }
-        
-        ADCaverage = currentSensorADCvalSum/numberOfSamples;
-        currentSample = currentSampleSum/numberOfSamples;
-        currentSampleSum =0;
-        currentSensorADCvalSum = 0;
     log(LOG_LEVEL::DEBUG, "ADC average value = %.2f%% ", ADCaverage);
     log(LOG_LEVEL::DEBUG, "Current Sensor value = %.2f%% A", currentSample);
 
     return currentSample;
 }
+
+bool CurrentSensor::readCurrentRMS(currentWaveform *waveform) {
+    harmonicAnalysis harmonics;
+    analogScanGroup group = rmsScanGroup(&harmonics);
+    adcSampleSums sums;
+    if (!sampleScanGroup(&group, &sums)) {
+        log(LOG_LEVEL::WARN, "Unable to acquire the AC current samples.");
+        return false;
+    }
+    waveformFromSums(&sums, waveform, &harmonics);
+    return true;
+}
+
+analogScanGroup CurrentSensor::rmsScanGroup(harmonicAnalysis *harmonics) {
+    // whole mains cycles at a fixed rate, so the DC mean of the samples is the DC of the current
+    analogScanGroup group = {};
+    group.sensors[0] = this;
+    group.n_sensors = 1;
+    group.n_samples = rms_cycles * RMS_SAMPLES_PER_CYCLE;
+    group.sample_rate_hz = mains_frequency_hz * RMS_SAMPLES_PER_CYCLE;
+    group.oversampling = RMS_OVERSAMPLING;
+    if (harmonics != nullptr) {
+        // every harmonic is a whole number of cycles of the acquisition, so each lands exactly on its DFT bin
+        harmonics->begin(1.0f / RMS_SAMPLES_PER_CYCLE);
+        group.harmonics = harmonics;
+    }
+    return group;
+}
+
+void CurrentSensor::waveformFromSums(const adcSampleSums *sums, currentWaveform *waveform,
+                                     const harmonicAnalysis *harmonics) {
+    float amp_per_lsb = real_MV_per_LSB * CURRENT_SENSOR_A_PER_MV;
+    float mean_raw = sums->mean();
+    float peak_raw = ((sums->max_raw - mean_raw) > (mean_raw - sums->min_raw)) ? (sums->max_raw - mean_raw)
+                                                                                : (mean_raw - sums->min_raw);
+    waveform->mean_raw = mean_raw;
+    waveform->mean_A = rawToAmp(mean_raw);
+    waveform->rms_A = sums->acRms() * amp_per_lsb;
+    waveform->peak_A = peak_raw * amp_per_lsb;
+    waveform->harmonics_valid = (harmonics != nullptr) && (harmonics->n_samples > 0);
+    waveform->thd_valid = false;
+    if (waveform->harmonics_valid) {
+        for (uint8_t h = 0; h < HARMONIC_COUNT; h++) {
+            waveform->harmonics_A[h] = harmonics->harmonicRMS(h) * amp_per_lsb;
+        }
+        waveform->thd_percent = harmonics->thdPercent();
+        waveform->thd_valid = (waveform->harmonics_A[0] >= HARMONICS_MIN_FUNDAMENTAL_A);
+    }
+
+    ADCaverage = waveform->mean_raw;
+    currentSample = waveform->mean_A;
+    trackZeroDrift(sums, false);
+
+    log(LOG_LEVEL::DEBUG, "AC current: mean = %.2f A | RMS = %.2f A | peak = %.2f A", waveform->mean_A,
+        waveform->rms_A, waveform->peak_A);
+    if (waveform->harmonics_valid) {
+        log(LOG_LEVEL::DEBUG, "Harmonics: %.2f | %.2f | %.2f | %.2f A | THD = %.2f %%", waveform->harmonics_A[0],
+            waveform->harmonics_A[1], waveform->harmonics_A[2], waveform->harmonics_A[3], waveform->thd_percent);
+    }
+}
+
+void CurrentSensor::trackZeroCurrent(void) {
+    if (drift_updated && ((millis() - last_drift_update_ms) < DRIFT_MIN_INTERVAL_MS)) {
+        return; // not due, so not worth sampling
+    }
+    adcSampleSums sums;
+    sampleRaw(DRIFT_SAMPLES, &sums);
+    trackZeroDrift(&sums, true);
+}
+
+void CurrentSensor::trackZeroDrift(const adcSampleSums *sums, bool load_off) {
+    if (!drift_tracking || (sums->n_samples < DRIFT_MIN_SAMPLES) ||
+        (drift_updated && ((millis() - last_drift_update_ms) < DRIFT_MIN_INTERVAL_MS))) {
+        return;
+    }
+    float mean_mv = sums->mean() * real_MV_per_LSB;
+    if (!load_off) {
+        // only a quiet reading near 0 A is taken to be the load being off
+        float current = rawToAmp(sums->mean());
+        float noise = sums->acRms() * real_MV_per_LSB * CURRENT_SENSOR_A_PER_MV;
+        if ((fabsf(current) > drift_window_A) || (noise > DRIFT_MAX_NOISE_A)) {
+            return;
+        }
+    }
+
+    // move part of the way towards the offset that would make this reading 0 A, bounded
+    float step = ((CURRENT_SENSOR_ZERO_MV - mean_mv) - zeroCurrentOffset) * DRIFT_WEIGHT;
+    step = constrain(step, -DRIFT_MAX_STEP_MV, DRIFT_MAX_STEP_MV);
+    zeroCurrentOffset = constrain(zeroCurrentOffset + step, calibratedZeroOffset - DRIFT_MAX_MV,
+                                  calibratedZeroOffset + DRIFT_MAX_MV);
+    last_drift_update_ms = millis();
+    drift_updated = true;
+
+    log(LOG_LEVEL::DEBUG, "Zero current offset drift tracked: %.2f mV (%.2f mV from calibration)", zeroCurrentOffset,
+        zeroCurrentOffset - calibratedZeroOffset);
+}
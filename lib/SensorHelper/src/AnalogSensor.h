@@ -11,7 +11,11 @@
 
 #include <LoRaWan-RAK4630.h> // Click to get library: https://platformio.org/lib/show/6601/SX126x-Arduino
 
-#include "Logging.h" /**< Go here to change the logging level for the entire application. */
+#include "AdcAcquisition.h"     /**< Background acquisition of ADC samples with the SAADC & EasyDMA. */
+#include "AdcSettings.h"        /**< Skips changing the ADC settings when they're already right. */
+#include "CurrentCalibration.h" /**< Zero current calibration saved in flash. */
+#include "HarmonicAnalysis.h"   /**< Goertzel filters of the mains harmonics. */
+#include "Logging.h"            /**< Go here to change the logging level for the entire application. */
 
 // Added ///
 #include "SerialDataExporter.h"
@@ -28,6 +32,89 @@ static const _eAnalogReference DEFAULT_ANALOG_REFERENCE = AR_DEFAULT; // Analog
 static const int DEFAULT_ANALOG_RESOLUTION = 10;                      // Resolution to default 10-bit (0..4095).
 static const uint32_t DEFAULT_OVERSAMPLING = 0;                       // Oversampling disabled
 
+#define ADC_ACQUISITION_MIN_SAMPLES 16 // Fewer samples than this are read with analogRead() instead of acquired
+
+/**
+ * @brief Integer sums of raw ADC samples, so the samples are only converted (to mV, A, etc.) once sampling is done.
+ * Shared by every AnalogSensor, see AnalogSensor::sampleRaw().
+ */
+struct adcSampleSums {
+    uint32_t n_samples = 0;   /**< Number of samples summed. */
+    uint64_t sum = 0;         /**< Sum of the raw samples. */
+    uint64_t sum_squares = 0; /**< Sum of the squared raw samples, for the RMS. */
+    uint16_t min_raw = UINT16_MAX; /**< Lowest raw sample. */
+    uint16_t max_raw = 0;          /**< Highest raw sample. */
+
+    /**
+     * @brief Add a raw sample.
+     * @param raw Raw ADC sample.
+     */
+    inline void add(uint32_t raw) {
+        n_samples++;
+        sum += raw;
+        sum_squares += (uint64_t)raw * raw;
+        min_raw = (raw < min_raw) ? raw : min_raw;
+        max_raw = (raw > max_raw) ? raw : max_raw;
+    };
+
+    /**
+     * @brief Add a block of raw samples from an acquisition, clamping them to 0 like analogRead() does.
+     * @param samples Raw samples.
+     * @param n Number of samples in the block.
+     * @param stride Only every stride-th sample from the first is added, e.g. one channel of a scan (Default: 1).
+     */
+    void addBlock(const int16_t *samples, uint16_t n, uint8_t stride = 1);
+
+    /**
+     * @brief Get the mean of the samples.
+     * @return Mean raw sample, 0 if none were summed.
+     */
+    inline float mean(void) const { return (n_samples == 0) ? 0 : (float)sum / n_samples; };
+
+    /**
+     * @brief Get the RMS of the samples.
+     * @return RMS raw sample, 0 if none were summed.
+     */
+    inline float rms(void) const { return (n_samples == 0) ? 0 : sqrtf((float)sum_squares / n_samples); };
+
+    /**
+     * @brief Get the RMS of the samples with their mean (the DC) removed, i.e. their standard deviation.
+     * Worked out from the exact integer sums, so it is exact while n_samples * max_raw < 2^32 (e.g. 260k 14-bit
+     * samples).
+     * @return AC RMS raw sample, 0 if none were summed.
+     */
+    inline float acRms(void) const {
+        return (n_samples == 0) ? 0 : sqrtf((float)((n_samples * sum_squares) - (sum * sum))) / n_samples;
+    };
+
+    /**
+     * @brief Checks if the mean is known well enough: the confidence interval of the mean is within a tolerance.
+     * Uses the variance of the samples so far (from the exact integer sums), assuming the samples are independent.
+     * @param tolerance_raw Half-width of the confidence interval to reach [raw ADC value].
+     * @param z z-score of the confidence, e.g. 1.96 for 95%.
+     * @return True if z * sqrt(variance / n_samples) <= tolerance_raw.
+     */
+    inline bool meanConverged(float tolerance_raw, float z) const {
+        // z^2 * (n * sum_squares - sum^2) / n^3 <= tolerance^2, without the divisions or square root
+        float n = n_samples;
+        float variance_n2 = (float)((n_samples * sum_squares) - (sum * sum));
+        return (n_samples > 1) && ((z * z * variance_n2) <= (tolerance_raw * tolerance_raw * n * n * n));
+    };
+};
+
+/**
+ * @brief When AnalogSensor::sampleRawUntil() stops sampling: once the mean is known to within a tolerance, but always
+ * after at least min_samples and at most max_samples.
+ */
+struct adcConvergence {
+    uint32_t min_samples; /**< Fewest samples, so the variance is known well enough to trust. */
+    uint32_t max_samples; /**< Most samples, taken if the mean never converges. */
+    float tolerance_raw;  /**< Half-width of the confidence interval of the mean to reach [raw ADC value]. */
+    float z;              /**< z-score of the confidence, e.g. 1.96 for 95%. */
+};
+
+struct analogScanGroup;
+
 /**
  * @brief AnalogSensor uses the onboard ADC to find the voltage of an analog sensor.
  */
@@ -70,10 +157,81 @@ class AnalogSensor {
 
     /**
      * @brief Get the sensor reading.
-     * Uses the ADC parameters passed in object instantiation.
+     * Uses the ADC parameters passed in object instantiation, only changing the ADC settings (& waiting for it to
+     * settle) if the last sensor read used different ones.
+     * @param n_samples Number of samples averaged into the reading (Default: 1).
      * @return Sensor reading in mV.
      */
-    float getSensorMV(void);
+    float getSensorMV(uint32_t n_samples = 1);
+
+    /**
+     * @brief Convert summed raw samples of this sensor to the sensor reading.
+     * @param sums Sums of the raw samples, e.g. from sampleScanGroup().
+     * @return Sensor reading in mV.
+     */
+    float sumsToMV(const adcSampleSums *sums);
+
+    /**
+     * @brief Take a number of raw samples, summing them as integers.
+     * Acquired in the background with acquireSamples() while the CPU sleeps, or read with analogRead() if there are
+     * fewer than ADC_ACQUISITION_MIN_SAMPLES samples (or the acquisition fails).
+     * @param n_samples Number of samples.
+     * @param sums Resulting sums of the samples.
+     */
+    void sampleRaw(uint32_t n_samples, adcSampleSums *sums);
+
+    /**
+     * @brief Take raw samples until their mean has converged, summing them as integers.
+     * The same as sampleRaw(), but the convergence is checked after each acquired block (or each analogRead()) and
+     * sampling stops as soon as the mean is within the tolerance.
+     * @param convergence When to stop.
+     * @param sums Resulting sums of the samples, sums->n_samples is the number actually taken.
+     */
+    void sampleRawUntil(const adcConvergence *convergence, adcSampleSums *sums);
+
+    /**
+     * @brief Sample several sensors together in one background acquisition, each sample a single SAADC scan of every
+     * sensor's pin (each with its own analog reference). Costs one acquisition, instead of one per sensor.
+     * The sensors must all have the same ADC resolution. Each sensor's conversion (e.g. sumsToMV()) is applied to its
+     * sums afterwards.
+     * @param group Sensors to sample & how.
+     * @param sums Resulting sums of the raw samples, one per sensor in the same order as the group.
+     * @return True if sampled, false if the sensors can't be scanned together or the acquisition failed.
+     */
+    static bool sampleScanGroup(const analogScanGroup *group, adcSampleSums *sums);
+
+    /**
+     * @brief Start acquiring samples in the background with the SAADC & EasyDMA, returning straight away.
+     * Uses the ADC parameters passed in object instantiation. The CPU is free (or asleep) until waitForSamples().
+     * @param n_samples Number of samples.
+     * @param handler Called from the SAADC interrupt with each block of raw samples.
+     * @param context Passed to the handler.
+     * @param sample_rate_hz Samples per second (Default: 0 = as fast as the oversampling allows).
+     * @return True if started, false if the ADC parameters aren't supported or an acquisition is already running.
+     */
+    bool acquireSamples(uint32_t n_samples, adcBlockHandler handler, void *context, uint32_t sample_rate_hz = 0);
+
+    /**
+     * @brief Start an acquisition with other settings, e.g. a different oversampling, returning straight away.
+     * @param config Settings of the acquisition, see acquisitionConfig().
+     * @return True if started, false if the settings aren't supported or an acquisition is already running.
+     */
+    bool acquireSamples(const adcAcquisitionConfig *config);
+
+    /**
+     * @brief Get the settings of an acquisition with the ADC parameters passed in object instantiation.
+     * @param n_samples Number of samples.
+     * @param handler Called from the SAADC interrupt with each block of raw samples.
+     * @param context Passed to the handler.
+     * @return Settings of the acquisition, to be changed as needed.
+     */
+    adcAcquisitionConfig acquisitionConfig(uint32_t n_samples, adcBlockHandler handler, void *context) const;
+
+    /**
+     * @brief Sleep until every sample from acquireSamples() has been handled.
+     * @return True if they were, false if the acquisition timed out (and was stopped).
+     */
+    bool waitForSamples(void);
 
   //private:
     /**
@@ -82,6 +240,11 @@ class AnalogSensor {
      */
     float readMV(void);
 
+    /**
+     * @brief Give the ADC the parameters passed in object instantiation, if another sensor changed them.
+     */
+    void useADC(void);
+
     /**
      * @brief Conversion factor that turns the raw ADC reading into sensor voltage (in mV).
      * Includes the compensation factor!!!
@@ -95,6 +258,19 @@ class AnalogSensor {
     float compensation_factor = 1; // Compensation factor sensor/pin - depends on the board hardware.
     float real_MV_per_LSB;         // Conversion factor that turns the raw ADC reading into the voltage
     float rawADC = 0;
+    uint32_t acquisition_timeout_ms = 0; // Time to wait for the samples of acquireSamples()
+};
+
+/**
+ * @brief Analog sensors sampled together in one SAADC scan, see AnalogSensor::sampleScanGroup().
+ */
+struct analogScanGroup {
+    AnalogSensor *sensors[ADC_MAX_SCAN_CHANNELS]; /**< Sensors to sample, each on its own pin. */
+    uint8_t n_sensors;                            /**< Number of sensors. */
+    uint32_t n_samples;                           /**< Samples of each sensor. */
+    uint32_t sample_rate_hz;                      /**< Samples per second, 0 for as fast as the oversampling allows. */
+    uint32_t oversampling; /**< Oversampling of every sensor (the SAADC has only one), 0 for the first sensor's. */
+    harmonicAnalysis *harmonics; /**< Also filters the first sensor's samples as they arrive, nullptr to skip. */
 };
 
 static const uint8_t BATTERY_PIN = WB_A0;
@@ -141,6 +317,46 @@ class BatteryLevel : public AnalogSensor {
 
 static const uint8_t CURRENT_SENSOR_PIN = WB_A1;
 static const float CURRENT_SENSOR_COMPENSATION_FACTOR = 1/0.6; 
+static const float CURRENT_SENSOR_ZERO_MV = 2500;   // Sensor output at zero current
+static const float CURRENT_SENSOR_A_PER_MV = 0.032; // 625 mV / 20 A = 31.25, 1/31.25 = 0.032
+
+#define DEFAULT_MAINS_FREQUENCY_HZ 50 // Mains frequency of the AC current, 50 or 60 Hz
+#define DEFAULT_RMS_CYCLES 10         // Whole mains cycles sampled for the AC current
+#define RMS_SAMPLES_PER_CYCLE 40      // Samples per mains cycle, i.e. 2 kHz at 50 Hz
+#define RMS_OVERSAMPLING 8            // ADC oversampling of the AC current samples, short enough for the sample rate
+
+#define DEFAULT_ADAPTIVE_TOLERANCE_A 0.01 // Half-width of the confidence interval of the adaptive mean current [A]
+#define DEFAULT_ADAPTIVE_MIN_SAMPLES 128  // Fewest samples of the adaptive mean current, a DMA block
+#define ADAPTIVE_CONFIDENCE_Z 1.96        // z-score of the adaptive confidence interval, 95%
+
+#define DEFAULT_DRIFT_WINDOW_A 0.1     // Drift tracking takes readings within this of 0 A as the load being off [A]
+#define DRIFT_MAX_NOISE_A 0.05         // ...as long as the samples' noise (AC RMS) is below this too [A]
+#define DRIFT_MIN_SAMPLES 128          // Fewest samples of a reading used for drift tracking
+#define DRIFT_SAMPLES 256              // Samples taken by trackZeroCurrent()
+#define DRIFT_MIN_INTERVAL_MS 60000    // Shortest time between drift updates [ms]
+#define DRIFT_WEIGHT 0.125             // Fraction of the offset error corrected by each drift update
+#define DRIFT_MAX_STEP_MV 0.5          // Most the offset moves in one drift update [mV]
+#define DRIFT_MAX_MV 15.0              // Most the offset drifts from the last calibration [mV]
+#define HARMONICS_MIN_FUNDAMENTAL_A 0.2 // Smallest fundamental the THD is worked out for [A], it's just noise below
+
+#define DEFAULT_EVENT_HIGH_A 20.0   // Current events: samples above this wake the device [A]
+#define DEFAULT_EVENT_LOW_A -20.0   // Current events: samples below this wake the device [A]
+#define EVENT_SAMPLE_INTERVAL_MS 10 // Time between the samples watched for current events [ms]
+#define EVENT_OVERSAMPLING 4        // ADC oversampling of the samples watched for current events
+
+/**
+ * @brief Current measured by CurrentSensor::readCurrentRMS(), all from the same samples.
+ */
+struct currentWaveform {
+    float mean_A;   /**< DC mean current, the same as readCurrentAmp(). */
+    float rms_A;    /**< True-RMS current with the DC removed. */
+    float peak_A;   /**< Largest difference from the DC mean current. */
+    float mean_raw; /**< Average raw ADC value, the same as CurrentSensor::ADCaverage. */
+    float harmonics_A[HARMONIC_COUNT]; /**< RMS current of each of HARMONIC_ORDERS, if harmonics_valid. */
+    float thd_percent;                 /**< Total harmonic distortion of the current, if thd_valid. */
+    bool harmonics_valid;              /**< True if the harmonics were analysed. */
+    bool thd_valid;                    /**< True if harmonics_valid & the fundamental is big enough for a THD. */
+};
 
 /**
  * @brief CurrentSensor inherits the AnalogSensor class adding an SoC function for sending via LoRaWAN.
@@ -177,25 +393,126 @@ class CurrentSensor : public AnalogSensor {
 
     bool currentSensorCalibrationMode();
     
+    /**
+     * @brief Calibrates the zero current offset, with no current flowing, and saves it to flash.
+     */
     void zeroCurrentOffsetCalibration();
 
+    /**
+     * @brief Reloads the zero current offset saved by zeroCurrentOffsetCalibration(), instead of recalibrating.
+     * Counts the boot towards the age of the calibration, so call it once per boot (e.g. in initSensors()).
+     * @return True if reloaded, false if there's no valid saved calibration, it was done with a different
+     * compensation factor or it is stale (CURRENT_CALIBRATION_MAX_BOOTS old), so it needs recalibrating.
+     */
+    bool restoreZeroCurrentCalibration(void);
+
+    /**
+     * @brief Takes a short sample (DRIFT_SAMPLES) while the load is known to be off, and uses it to track the drift of
+     * the zero current offset, rate limited & bounded like the drift tracking of every reading.
+     * Does nothing if the offset was updated less than DRIFT_MIN_INTERVAL_MS ago.
+     */
+    void trackZeroCurrent(void);
+
     /**
      * @brief  Read Sensor value and convert from mV to CURRENT SENSOR Amp.
-     * Uses 
+     * Averages numberOfSamples raw samples, acquired in the background with acquireSamples() while the CPU sleeps
+     * (or with blocking analogRead()s if that fails), then converts the average once.
+     * With adaptive_sampling it stops early, once the mean is within adaptive_tolerance_A (95% confidence) but after
+     * at least adaptive_min_samples. samples_used is the number of samples actually averaged.
      * @return CURRENT SENSOR Amp value.
      */
     float readCurrentAmp();
 
+    /**
+     * @brief Convert summed raw samples of this sensor to current, e.g. from sampleScanGroup().
+     * Sets ADCaverage & currentSample like readCurrentAmp().
+     * @param sums Sums of the raw samples.
+     * @return CURRENT SENSOR Amp value.
+     */
+    float sumsToAmp(const adcSampleSums *sums);
+
+    /**
+     * @brief Measure the AC current over rms_cycles whole mains cycles, at a fixed sample rate from a hardware timer.
+     * The samples are acquired in the background with acquireSamples() and summed as integers, then the DC mean, the
+     * true-RMS with the DC removed and the peak are all worked out from the same sums (so the DC offset is removed
+     * from every measurement without needing the zero current calibration).
+     * The harmonics & THD are also filtered out of the same samples as they arrive, see HarmonicAnalysis.h.
+     * @param waveform Resulting DC mean, RMS, peak current & harmonics.
+     * @return True if measured, false if the acquisition failed.
+     */
+    bool readCurrentRMS(currentWaveform *waveform);
+
+    /**
+     * @brief Get the scan group readCurrentRMS() samples, with only this sensor in it.
+     * Other sensors can be added to it and sampled at the same time, as the acquisition takes the same time (whole
+     * mains cycles) either way. Use waveformFromSums() on this sensor's sums.
+     * @param harmonics Started afresh & attached to the group to analyse the harmonics too, nullptr to skip.
+     * @return Scan group of the AC current.
+     */
+    analogScanGroup rmsScanGroup(harmonicAnalysis *harmonics = nullptr);
+
+    /**
+     * @brief Work out the AC current from summed raw samples of rmsScanGroup().
+     * Sets ADCaverage & currentSample like readCurrentAmp().
+     * @param sums Sums of this sensor's raw samples.
+     * @param waveform Resulting DC mean, RMS & peak current, plus the harmonics if given.
+     * @param harmonics Harmonic analysis of the same samples, nullptr if there isn't one.
+     */
+    void waveformFromSums(const adcSampleSums *sums, currentWaveform *waveform,
+                          const harmonicAnalysis *harmonics = nullptr);
+
+    /**
+     * @brief Convert a raw ADC value to current, with the zero current offset.
+     * @param raw Raw ADC value.
+     * @return Current [A].
+     */
+    float rawToAmp(float raw);
+
+    /**
+     * @brief Convert a current to a raw ADC value, with the zero current offset. The inverse of rawToAmp().
+     * @param amp Current [A].
+     * @return Raw ADC value.
+     */
+    float ampToRaw(float amp);
+
+    /**
+     * @brief Watches the current in the background while the CPU sleeps, until a sample is above event_high_A or below
+     * event_low_A. Uses the SAADC limit monitor (see AdcAcquisition.h), sampling every EVENT_SAMPLE_INTERVAL_MS, so
+     * short events between readings are caught without waking the CPU to poll. The sensor must be kept powered.
+     * Stop it with stopAdcLimitMonitor() before reading any analog sensor.
+     * @param handler Called from the SAADC interrupt on the first sample outside the thresholds.
+     * @param context Passed to the handler.
+     * @return True if started.
+     */
+    bool startEventMonitor(adcLimitHandler handler, void *context = nullptr);
+
+    /**
+     * @brief Tracks the drift of the zero current offset from a reading taken while no current flows.
+     * The offset only moves DRIFT_WEIGHT of the way towards the reading's zero offset, by at most DRIFT_MAX_STEP_MV
+     * once every DRIFT_MIN_INTERVAL_MS, and never more than DRIFT_MAX_MV from the last calibration.
+     * @param sums Sums of the raw samples of the reading.
+     * @param load_off True if the load is known to be off, otherwise the reading is only used if it's within
+     * drift_window_A of 0 A and quiet (below DRIFT_MAX_NOISE_A).
+     */
+    void trackZeroDrift(const adcSampleSums *sums, bool load_off);
+
     float zeroCurrentOffset = 0;                /* for zeroing current calibration */
+    float calibratedZeroOffset = 0;             /* zeroCurrentOffset of the last calibration, bounds the drift */
+    bool drift_tracking = true;                 /* update zeroCurrentOffset from low current readings */
+    float drift_window_A = DEFAULT_DRIFT_WINDOW_A; /* for trackZeroDrift() */
+    uint32_t last_drift_update_ms = 0;          /* millis() of the last drift update */
+    bool drift_updated = false;                 /* true once zeroCurrentOffset has been updated for drift */
 
     int numberOfSamples = 2000;
+    bool adaptive_sampling = false;                               /* for readCurrentAmp() */
+    float adaptive_tolerance_A = DEFAULT_ADAPTIVE_TOLERANCE_A;    /* for readCurrentAmp() */
+    uint32_t adaptive_min_samples = DEFAULT_ADAPTIVE_MIN_SAMPLES; /* for readCurrentAmp() */
+    uint32_t samples_used = 0;                                    /* samples averaged by the last readCurrentAmp() */
+    uint8_t mains_frequency_hz = DEFAULT_MAINS_FREQUENCY_HZ; /* for readCurrentRMS() */
+    uint8_t rms_cycles = DEFAULT_RMS_CYCLES;                  /* for readCurrentRMS() */
+    float event_high_A = DEFAULT_EVENT_HIGH_A; /* for startEventMonitor() */
+    float event_low_A = DEFAULT_EVENT_LOW_A;   /* for startEventMonitor() */
     float currentSample = 0;
-    float current_sensor_mV = 0;
-    float current_sensor_mV_sum = 0;            /* for zeroing current calibration */
-    float current_sample_mv = 0;                /* for zeroing current calibration */
-    float currentSampleRead  = 0;               /* to read the value of a sample */
-    float currentSampleSum   = 0;               /* accumulation of sample readings */
-    float currentSensorADCvalSum = 0;
     float ADCaverage = 0;
 
     // Enable this calibration mode if you want to calibrate the current sensor to with zero current while initalising
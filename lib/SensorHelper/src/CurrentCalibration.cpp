@@ -0,0 +1,81 @@
+#include "CurrentCalibration.h"
+
+using namespace Adafruit_LittleFS_Namespace;
+
+static bool fs_started = false;
+
+/**
+ * @brief Starts the internal file system, once.
+ * @return True if started.
+ */
+static bool startFS(void) {
+    if (!fs_started) {
+        fs_started = InternalFS.begin();
+        if (!fs_started) {
+            log(LOG_LEVEL::ERROR, "Unable to start the internal file system.");
+        }
+    }
+    return fs_started;
+}
+
+/**
+ * @brief Get the CRC-32 (IEEE) of a calibration, up to its crc.
+ * @param calibration Calibration.
+ * @return CRC-32.
+ */
+static uint32_t calibrationCRC(const currentCalibration *calibration) {
+    const uint8_t *bytes = (const uint8_t *)calibration;
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (size_t i = 0; i < offsetof(currentCalibration, crc); i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320UL : 0);
+        }
+    }
+    return ~crc;
+}
+
+bool loadCurrentCalibration(currentCalibration *calibration) {
+    if (!startFS()) {
+        return false;
+    }
+    File file(InternalFS);
+    if (!file.open(CURRENT_CALIBRATION_FILE, FILE_O_READ)) {
+        log(LOG_LEVEL::DEBUG, "No saved current calibration.");
+        return false;
+    }
+    size_t length = file.read(calibration, sizeof(currentCalibration));
+    file.close();
+
+    if ((length != sizeof(currentCalibration)) || (calibration->magic != CURRENT_CALIBRATION_MAGIC) ||
+        (calibration->crc != calibrationCRC(calibration))) {
+        log(LOG_LEVEL::WARN, "Saved current calibration is corrupt.");
+        return false;
+    }
+    return true;
+}
+
+bool saveCurrentCalibration(currentCalibration *calibration) {
+    if (!startFS()) {
+        return false;
+    }
+    calibration->magic = CURRENT_CALIBRATION_MAGIC;
+    calibration->crc = calibrationCRC(calibration);
+
+    // FILE_O_WRITE appends, so the old calibration is removed first
+    InternalFS.remove(CURRENT_CALIBRATION_FILE);
+    File file(InternalFS);
+    if (!file.open(CURRENT_CALIBRATION_FILE, FILE_O_WRITE)) {
+        log(LOG_LEVEL::ERROR, "Unable to save the current calibration.");
+        return false;
+    }
+    size_t length = file.write((const uint8_t *)calibration, sizeof(currentCalibration));
+    file.close();
+    return length == sizeof(currentCalibration);
+}
+
+void eraseCurrentCalibration(void) {
+    if (startFS()) {
+        InternalFS.remove(CURRENT_CALIBRATION_FILE);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef CURRENT_CALIBRATION_H
+#define CURRENT_CALIBRATION_H
+
+/**
+ * @file CurrentCalibration.h
+ * @author Kalina Knight
+ * @brief Keeps the zero current calibration of the CurrentSensor in the internal flash (LittleFS), so it can be
+ * reloaded at boot instead of recalibrating every time.
+ * The calibration is stored with a magic number & CRC (its validity) and the number of boots since it was calibrated
+ * (its age, there's no real time clock), see CurrentSensor::restoreZeroCurrentCalibration().
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+#include <InternalFileSystem.h>
+#include <stddef.h>
+
+#include "Logging.h"
+
+#define CURRENT_CALIBRATION_FILE "/current_cal.bin" /**< LittleFS file of the calibration. */
+#define CURRENT_CALIBRATION_MAGIC 0x4C414331UL      /**< "1CAL", changed if currentCalibration changes. */
+#define CURRENT_CALIBRATION_MAX_BOOTS 100           /**< Boots after which the calibration is stale. */
+
+/** @brief Zero current calibration as stored in flash. */
+struct currentCalibration {
+    uint32_t magic;            /**< CURRENT_CALIBRATION_MAGIC. */
+    float zero_offset_mv;      /**< CurrentSensor::zeroCurrentOffset. */
+    float compensation_factor; /**< Compensation factor the calibration was done with. */
+    uint32_t boots;            /**< Boots since the calibration, its age. */
+    uint32_t crc;              /**< CRC-32 of everything before it. */
+};
+
+/**
+ * @brief Loads the calibration from flash.
+ * @param calibration Resulting calibration.
+ * @return True if there is a valid one (right magic number & CRC).
+ */
+bool loadCurrentCalibration(currentCalibration *calibration);
+
+/**
+ * @brief Saves the calibration to flash, replacing the old one.
+ * @param calibration Calibration to save, its magic number & CRC are filled in.
+ * @return True if saved.
+ */
+bool saveCurrentCalibration(currentCalibration *calibration);
+
+/**
+ * @brief Erases the calibration from flash, so the next boot recalibrates.
+ */
+void eraseCurrentCalibration(void);
+
+#endif // CURRENT_CALIBRATION_H
@@ -0,0 +1,52 @@
+#include "HarmonicAnalysis.h"
+
+void goertzelFilter::begin(float cycles_per_sample) {
+    coeff = 2 * cosf(2 * (float)M_PI * cycles_per_sample);
+    s1 = 0;
+    s2 = 0;
+}
+
+float goertzelFilter::rmsAmplitude(uint32_t n_samples) const {
+    if (n_samples == 0) {
+        return 0;
+    }
+    // |X|^2 of the bin, then a sinusoid's peak is 2|X|/N, so its RMS is sqrt(2)|X|/N
+    float power = (s1 * s1) + (s2 * s2) - (coeff * s1 * s2);
+    return sqrtf(2 * ((power > 0) ? power : 0)) / n_samples;
+}
+
+void harmonicAnalysis::begin(float fundamental_cycles_per_sample) {
+    for (uint8_t h = 0; h < HARMONIC_COUNT; h++) {
+        filters[h].begin(HARMONIC_ORDERS[h] * fundamental_cycles_per_sample);
+    }
+    n_samples = 0;
+    dc_estimate = 0;
+}
+
+void harmonicAnalysis::addBlock(const int16_t *samples, uint16_t n, uint8_t stride) {
+    if ((n_samples == 0) && (n > 0)) {
+        dc_estimate = samples[0];
+    }
+    for (uint16_t i = 0; i < n; i += stride, n_samples++) {
+        float x = samples[i] - dc_estimate;
+        for (uint8_t h = 0; h < HARMONIC_COUNT; h++) {
+            filters[h].add(x);
+        }
+    }
+}
+
+float harmonicAnalysis::harmonicRMS(uint8_t h) const {
+    return filters[h].rmsAmplitude(n_samples);
+}
+
+float harmonicAnalysis::thdPercent(void) const {
+    float fundamental = harmonicRMS(0);
+    if (fundamental <= 0) {
+        return 0;
+    }
+    float harmonics_squared = 0;
+    for (uint8_t h = 1; h < HARMONIC_COUNT; h++) {
+        harmonics_squared += harmonicRMS(h) * harmonicRMS(h);
+    }
+    return 100 * sqrtf(harmonics_squared) / fundamental;
+}
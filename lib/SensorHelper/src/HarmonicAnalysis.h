@@ -0,0 +1,94 @@
+#ifndef HARMONIC_ANALYSIS_H
+#define HARMONIC_ANALYSIS_H
+
+/**
+ * @file HarmonicAnalysis.h
+ * @author Kalina Knight
+ * @brief Goertzel filters at the mains fundamental & its odd harmonics, for finding the harmonics & THD of a current
+ * waveform as it is sampled.
+ * Each filter works out a single DFT bin one sample at a time, so the samples are filtered block by block as they're
+ * acquired (from the block handler) and no waveform buffer is needed. Sampling a whole number of mains cycles puts
+ * every harmonic exactly on a bin, so there's no leakage between them (or from the DC).
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+
+#define HARMONIC_COUNT 4 /**< Harmonics analysed: the fundamental, 3rd, 5th & 7th. */
+
+/** @brief Order of each analysed harmonic, 1 being the fundamental. */
+static const uint8_t HARMONIC_ORDERS[HARMONIC_COUNT] = { 1, 3, 5, 7 };
+
+/**
+ * @brief A Goertzel filter, i.e. a single DFT bin updated one sample at a time.
+ */
+struct goertzelFilter {
+    float coeff = 0; /**< 2cos(2pi * cycles per sample) of the bin. */
+    float s1 = 0;    /**< Last output. */
+    float s2 = 0;    /**< Output before last. */
+
+    /**
+     * @brief Starts the filter afresh at a frequency.
+     * @param cycles_per_sample Frequency of the bin / sample rate.
+     */
+    void begin(float cycles_per_sample);
+
+    /**
+     * @brief Filter a sample.
+     * @param x Sample.
+     */
+    inline void add(float x) {
+        float s0 = x + (coeff * s1) - s2;
+        s2 = s1;
+        s1 = s0;
+    };
+
+    /**
+     * @brief Get the RMS amplitude of the bin's sinusoid.
+     * @param n_samples Number of samples filtered.
+     * @return RMS amplitude, in the units of the samples.
+     */
+    float rmsAmplitude(uint32_t n_samples) const;
+};
+
+/**
+ * @brief Goertzel filters at the fundamental & its HARMONIC_ORDERS harmonics, of a block by block acquisition.
+ */
+struct harmonicAnalysis {
+    goertzelFilter filters[HARMONIC_COUNT]; /**< Filter of each harmonic. */
+    uint32_t n_samples = 0;                 /**< Number of samples filtered. */
+    float dc_estimate = 0;                  /**< First sample, taken off every sample to keep the filters' precision. */
+
+    /**
+     * @brief Starts the analysis afresh.
+     * @param fundamental_cycles_per_sample Fundamental frequency / sample rate, e.g. 1/40 for 40 samples per cycle.
+     */
+    void begin(float fundamental_cycles_per_sample);
+
+    /**
+     * @brief Filter a block of raw samples from an acquisition, quick enough for the SAADC interrupt.
+     * @param samples Raw samples.
+     * @param n Number of samples in the block.
+     * @param stride Only every stride-th sample from the first is filtered, e.g. one channel of a scan (Default: 1).
+     */
+    void addBlock(const int16_t *samples, uint16_t n, uint8_t stride = 1);
+
+    /**
+     * @brief Get the RMS amplitude of a harmonic.
+     * @param h Index of the harmonic in HARMONIC_ORDERS.
+     * @return RMS amplitude [raw ADC value].
+     */
+    float harmonicRMS(uint8_t h) const;
+
+    /**
+     * @brief Get the total harmonic distortion, of the analysed harmonics only.
+     * @return sqrt(sum of the harmonics^2) / fundamental [%], 0 if there's no fundamental.
+     */
+    float thdPercent(void) const;
+};
+
+#endif // HARMONIC_ANALYSIS_H
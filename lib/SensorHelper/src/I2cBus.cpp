@@ -0,0 +1,97 @@
+#include "I2cBus.h"
+
+static bool bus_initialised = false;
+static i2cBusStats stats;
+
+void initI2cBus(uint32_t clock_hz) {
+    if (!bus_initialised) {
+        Wire.begin();
+        bus_initialised = true;
+    }
+    Wire.setClock((clock_hz < I2C_MAX_CLOCK_HZ) ? clock_hz : I2C_MAX_CLOCK_HZ);
+}
+
+bool i2cReadRegisters(uint8_t address, uint8_t first_register, uint8_t *data, uint8_t length) {
+    if ((length == 0) || (length > I2C_MAX_BURST_BYTES)) {
+        return false;
+    }
+    uint32_t start_us = startI2cTransaction();
+    Wire.beginTransmission(address);
+    Wire.write(first_register);
+    // no stop, so the read follows with a repeated start
+    bool success = (Wire.endTransmission(false) == 0) && (Wire.requestFrom(address, length) == length);
+    for (uint8_t i = 0; success && (i < length); i++) {
+        data[i] = Wire.read();
+    }
+    endI2cTransaction(address, start_us, 1 + length, success);
+    return success;
+}
+
+bool i2cWrite(uint8_t address, const uint8_t *data, uint8_t length) {
+    if ((length == 0) || (length > I2C_MAX_BURST_BYTES)) {
+        return false;
+    }
+    uint32_t start_us = startI2cTransaction();
+    Wire.beginTransmission(address);
+    for (uint8_t i = 0; i < length; i++) {
+        Wire.write(data[i]);
+    }
+    bool success = (Wire.endTransmission() == 0);
+    endI2cTransaction(address, start_us, length, success);
+    return success;
+}
+
+bool i2cRead(uint8_t address, uint8_t *data, uint8_t length) {
+    if ((length == 0) || (length > I2C_MAX_BURST_BYTES)) {
+        return false;
+    }
+    uint32_t start_us = startI2cTransaction();
+    bool success = (Wire.requestFrom(address, length) == length);
+    for (uint8_t i = 0; success && (i < length); i++) {
+        data[i] = Wire.read();
+    }
+    endI2cTransaction(address, start_us, length, success);
+    return success;
+}
+
+bool i2cWriteRegister(uint8_t address, uint8_t reg, uint8_t value) {
+    uint32_t start_us = startI2cTransaction();
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    Wire.write(value);
+    bool success = (Wire.endTransmission() == 0);
+    endI2cTransaction(address, start_us, 2, success);
+    return success;
+}
+
+uint32_t startI2cTransaction(void) {
+    return micros();
+}
+
+void endI2cTransaction(uint8_t address, uint32_t start_us, uint8_t bytes, bool success) {
+    uint32_t elapsed_us = micros() - start_us;
+    stats.transactions++;
+    stats.errors += success ? 0 : 1;
+    stats.bytes += bytes;
+    stats.total_us += elapsed_us;
+    stats.max_transaction_us = (elapsed_us > stats.max_transaction_us) ? elapsed_us : stats.max_transaction_us;
+    if (!success) {
+        log(LOG_LEVEL::WARN, "I2C transaction with 0x%02X failed after %lu us.", address, elapsed_us);
+    }
+}
+
+const i2cBusStats *getI2cStats(void) {
+    return &stats;
+}
+
+void logI2cStats(void) {
+    if (stats.transactions > 0) {
+        log(LOG_LEVEL::DEBUG, "I2C: %lu transaction(s) (%lu failed) | %lu bytes | %lu us total | %lu us longest",
+            stats.transactions, stats.errors, stats.bytes, stats.total_us, stats.max_transaction_us);
+    }
+    resetI2cStats();
+}
+
+void resetI2cStats(void) {
+    stats = i2cBusStats();
+}
@@ -0,0 +1,114 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/**
+ * @file I2cBus.h
+ * @author Kalina Knight
+ * @brief Owns the shared I2C bus (Wire) of the WisBlock sensors: initialises it once at I2C_CLOCK_HZ, does burst
+ * register reads in a single transaction, and times every transaction so the I2C time of each wake up can be logged.
+ *
+ * The sensor libraries (SHTC3 & BME680) do their own Wire transactions, so the sensor helpers time those with
+ * startI2cTransaction() & endI2cTransaction() around each library call.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "Logging.h"
+
+#define I2C_MAX_CLOCK_HZ 400000 /**< Fastest clock of the nRF52 TWIM (fast mode), it has no 1 MHz fast mode plus. */
+#define I2C_CLOCK_HZ 400000     /**< Clock of the bus, the SHTC3 (up to 1 MHz) & BME680 (up to 3.4 MHz) are fine. */
+#define I2C_MAX_BURST_BYTES 32  /**< Most bytes of a burst read, the Wire buffer size. */
+
+/** @brief Timing of the I2C transactions since resetI2cStats(). */
+struct i2cBusStats {
+    uint32_t transactions = 0;       /**< Number of transactions. */
+    uint32_t errors = 0;             /**< Transactions that failed. */
+    uint32_t bytes = 0;              /**< Bytes read & written, of the transactions that count them. */
+    uint32_t total_us = 0;           /**< Time of every transaction [us]. */
+    uint32_t max_transaction_us = 0; /**< Time of the longest transaction [us]. */
+};
+
+/**
+ * @brief Initialises the bus the first time it's called (Wire.begin()), then (every time) sets its clock.
+ * Safe to call from every sensor's init, and needed after a sensor library calls Wire.begin() itself as that resets
+ * the clock to 100 kHz.
+ * @param clock_hz Clock of the bus [Hz], limited to I2C_MAX_CLOCK_HZ (Default: I2C_CLOCK_HZ).
+ */
+void initI2cBus(uint32_t clock_hz = I2C_CLOCK_HZ);
+
+/**
+ * @brief Reads consecutive registers in a single transaction: the first register address is written, then every byte
+ * is read after a repeated start, instead of a transaction per register.
+ * @param address 7-bit I2C address.
+ * @param first_register First register to read, the device increments the address after each byte.
+ * @param data Buffer the register values are read into.
+ * @param length Number of registers to read, up to I2C_MAX_BURST_BYTES.
+ * @return True if every register was read. False if not.
+ */
+bool i2cReadRegisters(uint8_t address, uint8_t first_register, uint8_t *data, uint8_t length);
+
+/**
+ * @brief Writes bytes in a single transaction, e.g. a command of a device without registers.
+ * @param address 7-bit I2C address.
+ * @param data Bytes to write.
+ * @param length Number of bytes, up to I2C_MAX_BURST_BYTES.
+ * @return True if written (acknowledged). False if not.
+ */
+bool i2cWrite(uint8_t address, const uint8_t *data, uint8_t length);
+
+/**
+ * @brief Reads bytes in a single transaction, e.g. the result of a command.
+ * @param address 7-bit I2C address.
+ * @param data Buffer the bytes are read into.
+ * @param length Number of bytes, up to I2C_MAX_BURST_BYTES.
+ * @return True if every byte was read. False if not, e.g. the device didn't acknowledge as it's busy.
+ */
+bool i2cRead(uint8_t address, uint8_t *data, uint8_t length);
+
+/**
+ * @brief Writes a register in a single transaction.
+ * @param address 7-bit I2C address.
+ * @param reg Register to write.
+ * @param value Value to write.
+ * @return True if written. False if not.
+ */
+bool i2cWriteRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Starts timing a transaction done outside of this module, e.g. by a sensor library.
+ * @return Start time, to pass to endI2cTransaction().
+ */
+uint32_t startI2cTransaction(void);
+
+/**
+ * @brief Ends timing a transaction, adding it to the stats.
+ * @param address 7-bit I2C address of the device, for logging.
+ * @param start_us Start time from startI2cTransaction().
+ * @param bytes Bytes read & written, 0 if unknown.
+ * @param success True if the transaction succeeded.
+ */
+void endI2cTransaction(uint8_t address, uint32_t start_us, uint8_t bytes, bool success);
+
+/**
+ * @brief Get the timing of the transactions since resetI2cStats().
+ * @return I2C bus stats.
+ */
+const i2cBusStats *getI2cStats(void);
+
+/**
+ * @brief Logs the I2C bus stats (at the DEBUG level) then resets them, e.g. once per wake up.
+ */
+void logI2cStats(void);
+
+/**
+ * @brief Resets the I2C bus stats.
+ */
+void resetI2cStats(void);
+
+#endif // I2C_BUS_H
@@ -1,15 +1,86 @@
 #include "RAK1901_helper.h"
 
+/**
+ * @brief Checks the CRC of a word read from the SHTC3: CRC-8, polynomial 0x31 & initialised to 0xFF.
+ * @param data MSB then LSB of the word, then its CRC.
+ * @return True if the CRC matches.
+ */
+static bool shtc3CrcValid(const uint8_t *data) {
+    uint8_t crc = 0xFF;
+    for (uint8_t i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? ((crc << 1) ^ 0x31) : (crc << 1);
+        }
+    }
+    return crc == data[2];
+}
+
+bool RAK1901::writeCommand(uint16_t command) {
+    uint8_t bytes[2] = { (uint8_t)(command >> 8), (uint8_t)command };
+    return i2cWrite(SHTC3_ADDR_7BIT, bytes, sizeof(bytes));
+}
+
 bool RAK1901::init(void) {
-    Wire.begin(); // The default settings use Wire (default Arduino I2C port).
-    // Wire.setClock(400000); // I2C speed is global for that bus, so using 400kHz or 100kHz is recommended.
+    initI2cBus(); // The default settings use Wire (default Arduino I2C port), shared with the other sensors.
 
     // SHTC3 functions return value of type "SHTC3_Status_TypeDef".
-    return (begin() == SHTC3_Status_Nominal);
+    uint32_t start_us = startI2cTransaction();
+    bool success = (begin() == SHTC3_Status_Nominal);
+    endI2cTransaction(SHTC3_ADDR_7BIT, start_us, 0, success);
+    if (success) {
+        // asleep until the first reading
+        writeCommand(SLEEP_COMMAND);
+    }
+    return success;
 }
 
-bool RAK1901::dataReady(void) {
-    update();
-    // SHTC3 functions return value of type "SHTC3_Status_TypeDef".
-    return (lastStatus == SHTC3_Status_Nominal);
-}
\ No newline at end of file
+bool RAK1901::startReading(void) {
+    measuring = false;
+    if (!writeCommand(WAKEUP_COMMAND)) {
+        return false;
+    }
+    delayMicroseconds(WAKEUP_TIME_US);
+
+    // temperature first, clock stretching disabled: the SHTC3 NACKs reads until the measurement is done
+    measuring = writeCommand(low_power_mode ? SHTC3_CMD_CSD_TF_LPM : SHTC3_CMD_CSD_TF_NPM);
+    measurement_start_ms = millis();
+    if (!measuring) {
+        writeCommand(SLEEP_COMMAND);
+    }
+    return measuring;
+}
+
+bool RAK1901::collectReading(void) {
+    if (!measuring && !startReading()) {
+        log(LOG_LEVEL::WARN, "Unable to start an SHTC3 measurement.");
+        return false;
+    }
+    measuring = false;
+
+    uint32_t measurement_ms = low_power_mode ? LOW_POWER_MEASUREMENT_MS : NORMAL_MEASUREMENT_MS;
+    uint32_t elapsed_ms = millis() - measurement_start_ms;
+    if (elapsed_ms < measurement_ms) {
+        delay(measurement_ms - elapsed_ms);
+    }
+    uint8_t data[6] = {};
+    bool success = false;
+    for (uint8_t attempt = 0; !success && (attempt < MEASUREMENT_POLL_ATTEMPTS); attempt++) {
+        if (attempt > 0) {
+            delay(1);
+        }
+        success = i2cRead(SHTC3_ADDR_7BIT, data, sizeof(data));
+    }
+    success = success && shtc3CrcValid(&data[0]) && shtc3CrcValid(&data[3]);
+
+    // back to sleep whatever happened, until the next reading
+    writeCommand(SLEEP_COMMAND);
+
+    if (!success) {
+        log(LOG_LEVEL::WARN, "Unable to read the SHTC3.");
+        return false;
+    }
+    temperature = -45 + (175 * (float)((data[0] << 8) | data[1]) / 65536);
+    humidity = 100 * (float)((data[3] << 8) | data[4]) / 65536;
+    return true;
+}
@@ -1,11 +1,16 @@
 #include "RAK1906_helper.h"
 
 bool RAK1906::init(initRAK1906Sensors *initSensors) {
-    Wire.begin();
-    if (!begin(BME680_ADDRESS)) {
+    initI2cBus();
+    uint32_t start_us = startI2cTransaction();
+    bool success = begin(BME680_ADDRESS);
+    endI2cTransaction(BME680_ADDRESS, start_us, 0, success);
+    if (!success) {
         log(LOG_LEVEL::ERROR, "Could not find a valid BME680 sensor, check wiring!");
         return false;
     }
+    // the library's begin() calls Wire.begin() again, which sets the clock back to 100kHz
+    initI2cBus();
 
     // Set up oversampling and filter initialization
     if (initSensors->temp) {
@@ -28,10 +33,75 @@ bool RAK1906::init(initRAK1906Sensors *initSensors) {
     }
     if (initSensors->gas) {
         setIIRFilterSize(GAS_IIR_FILTER);
-        setGasHeater(GAS_HEATER_TEMP_C, GAS_HEATER_TIME_MS);
-    } else {
+    }
+    // the heater is only turned on for the readings that measure the gas resistance
+    gas_enabled = initSensors->gas;
+    heater_on = true; // so it's written off whatever the library's default is
+    setHeater(false, 0);
+    has_gas_reading = false;
+    return true;
+}
+
+bool RAK1906::gasDue(void) {
+    if (!has_gas_reading || ((readings_since_gas + 1) >= gas_interval)) {
+        return true;
+    }
+    // uses the last reading, as this one hasn't been taken yet
+    return (fabsf(temperature - gas_temperature) >= gas_trigger_temperature) ||
+           (fabsf(humidity - gas_humidity) >= gas_trigger_humidity);
+}
+
+void RAK1906::setHeater(bool on, uint16_t heater_time_ms) {
+    if (on) {
+        setGasHeater(GAS_HEATER_TEMP_C, heater_time_ms);
+    } else if (heater_on) {
         // disable sensor
         setGasHeater(0, 0);
     }
+    heater_on = on;
+}
+
+bool RAK1906::startReading(void) {
+    gas_heated = gas_enabled && gasDue();
+    if (gas_heated && (gas_heater_profile == GAS_HEATER_PROFILE::STEP)) {
+        // overdrive the hot plate briefly so it gets to temperature sooner, then only hold it there briefly
+        setGasHeater(GAS_STEP_PREHEAT_TEMP_C, GAS_STEP_PREHEAT_TIME_MS);
+        heater_on = true;
+        performReading();
+        setHeater(true, GAS_STEP_HEATER_TIME_MS);
+    } else {
+        setHeater(gas_heated, GAS_HEATER_TIME_MS);
+    }
+
+    uint32_t start_us = startI2cTransaction();
+    bool success = (beginReading() != 0);
+    endI2cTransaction(BME680_ADDRESS, start_us, 0, success);
+    return success;
+}
+
+bool RAK1906::collectReading(void) {
+    // sleep through the rest of the conversion first, so only the reading of the results is timed as I2C
+    int remaining_ms = remainingReadingMillis();
+    if (remaining_ms > 0) {
+        delay(remaining_ms);
+    }
+    uint32_t start_us = startI2cTransaction();
+    bool success = endReading();
+    endI2cTransaction(BME680_ADDRESS, start_us, 0, success);
+    if (!success) {
+        gas_measured = false;
+        return false;
+    }
+
+    // the library zeroes the gas resistance if the heater didn't reach its temperature
+    gas_measured = gas_heated && (gas_resistance != 0);
+    if (gas_heated) {
+        has_gas_reading = true;
+        readings_since_gas = 0;
+        gas_temperature = temperature;
+        gas_humidity = humidity;
+    } else if (readings_since_gas < UINT16_MAX) {
+        readings_since_gas++;
+    }
     return true;
 }
@@ -19,8 +19,19 @@
 
 #include <Adafruit_BME680.h>
 
+#include "I2cBus.h" /**< Shared I2C bus. */
 #include "Logging.h"
 
+#define DEFAULT_GAS_INTERVAL 10            // Gas heater runs every Nth reading (and when the environment changes)
+#define DEFAULT_GAS_TRIGGER_TEMPERATURE 1.0 // Temperature change since the last gas reading that triggers one [C]
+#define DEFAULT_GAS_TRIGGER_HUMIDITY 5.0    // Humidity change since the last gas reading that triggers one [%]
+
+/** @brief How the gas heater is run for a gas reading. */
+enum class GAS_HEATER_PROFILE {
+    SINGLE, /**< One conversion holding GAS_HEATER_TEMP_C for GAS_HEATER_TIME_MS. */
+    STEP,   /**< A short overdriven pre-heat conversion, then a shorter hold at GAS_HEATER_TEMP_C. */
+};
+
 typedef struct initRAK1906Sensors {
     bool temp;
     bool humi;
@@ -39,13 +50,44 @@ class RAK1906 : public Adafruit_BME680 {
     const uint8_t GAS_IIR_FILTER = BME680_FILTER_SIZE_3;
     const uint16_t GAS_HEATER_TEMP_C = 320;  // gas heater temperature
     const uint16_t GAS_HEATER_TIME_MS = 150; // gas heater time on
+    const uint16_t GAS_STEP_PREHEAT_TEMP_C = 400;  // STEP profile: pre-heat temperature, the heater's max
+    const uint16_t GAS_STEP_PREHEAT_TIME_MS = 30;  // STEP profile: pre-heat time on
+    const uint16_t GAS_STEP_HEATER_TIME_MS = 75;   // STEP profile: time on at GAS_HEATER_TEMP_C after the pre-heat
+
+    bool gas_enabled = false;     // gas resistance enabled by init()
+    bool heater_on = false;       // heater settings of the BME680 are on
+    bool gas_heated = false;      // the conversion started by startReading() runs the heater
+    bool gas_measured = false;    // the last reading measured the gas resistance
+    bool has_gas_reading = false; // a gas reading has been taken
+    uint16_t readings_since_gas = 0;
+    float gas_temperature = 0; // temperature of the last gas reading
+    float gas_humidity = 0;    // humidity of the last gas reading
+
+    /**
+     * @brief Checks if the next reading should run the gas heater: every gas_interval readings, or if the temperature
+     * or humidity of the last reading have moved by the trigger amounts since the last gas reading.
+     * @return True if due.
+     */
+    bool gasDue(void);
+
+    /**
+     * @brief Turns the gas heater settings on or off, only writing them to the BME680 if they change.
+     * @param on True for the heater on.
+     * @param heater_time_ms Time on [ms].
+     */
+    void setHeater(bool on, uint16_t heater_time_ms);
 
   public:
+    uint16_t gas_interval = DEFAULT_GAS_INTERVAL;                    /* gas heater every Nth reading, 1 for every one */
+    float gas_trigger_temperature = DEFAULT_GAS_TRIGGER_TEMPERATURE; /* temperature change triggering a gas reading */
+    float gas_trigger_humidity = DEFAULT_GAS_TRIGGER_HUMIDITY;       /* humidity change triggering a gas reading */
+    GAS_HEATER_PROFILE gas_heater_profile = GAS_HEATER_PROFILE::SINGLE;
+
     /**
      * @brief Initialise the environmental sensing unit.
      * Sets the oversampling of the temperature, humidity & pressure sensors.
      * Plus sets the IIR filter size & heater settings for the gas resistance sensor.
-     * Calls Wire.begin() in the process.
+     * Initialises the shared I2C bus (initI2cBus()) in the process.
      * @param initSensors Struct of flags indicating which sensors should be enabled.
      * @return True if successful. False if not.
      */
@@ -53,9 +95,40 @@ class RAK1906 : public Adafruit_BME680 {
 
     /**
      * @brief Gets the environmental sensing unit data ready.
+     * Blocks through the whole conversion, including the gas heater if it's due. See startReading() to do something
+     * else in the meantime.
      * @return True if data is ready. False if not.
      */
-    inline bool dataReady(void) { return performReading(); };
+    inline bool dataReady(void) { return startReading() && collectReading(); };
+
+    /**
+     * @brief Starts a forced mode conversion and returns straight away, so other sensors can be read while it converts.
+     * Collect the data with collectReading().
+     * The gas heater only runs if the gas resistance is enabled and a gas reading is due (see gas_interval), with the
+     * STEP profile its pre-heat conversion is done (blocking) first.
+     * @return True if started. False if not.
+     */
+    bool startReading(void);
+
+    /**
+     * @brief Checks if the conversion started by startReading() is done, so collectReading() won't wait.
+     * @return True if done (or none was started). False if still converting.
+     */
+    inline bool readingDone(void) { return remainingReadingMillis() <= 0; };
+
+    /**
+     * @brief Gets the data of the conversion started by startReading() ready, sleeping through whatever is left of it.
+     * Starts (and waits for) a conversion if none was started, like dataReady().
+     * @return True if data is ready. False if not.
+     */
+    bool collectReading(void);
+
+    /**
+     * @brief Checks if the last reading measured the gas resistance, i.e. the heater ran & reached its temperature.
+     * Between gas readings getGasResistance() is stale.
+     * @return True if measured.
+     */
+    inline bool gasMeasured(void) { return gas_measured; };
 
     /**
      * @brief Get temperature.
@@ -0,0 +1,200 @@
+#ifndef SENSOR_DRIVERS_H
+#define SENSOR_DRIVERS_H
+
+/**
+ * @file SensorDrivers.h
+ * @author Kalina Knight
+ * @brief The sensor drivers of the SensorHelper, and the compile-time registry of the ones built in (sensorDrivers).
+ *
+ * A sensor driver is a struct of static functions & constants, it's never instantiated:
+ *
+ *     struct exampleDriver {
+ *         static constexpr uint16_t FIELDS = ...;   // sensor fields it can provide (SEND_ masks)
+ *         static constexpr uint32_t WARM_UP_MS = 0; // time after turning on before it can be read [ms]
+ *         static bool init(uint16_t fields);        // gets it ready to read these fields, false if it can't
+ *         static bool powerOn(uint16_t fields);     // true if it was off, so it needs its WARM_UP_MS
+ *         static void powerOff(uint16_t fields);
+ *         static void start(uint16_t fields);       // starts a reading, returning straight away if it can
+ *         static void collect(uint16_t fields, uint16_t port_fields, sensorData *data); // fills in its fields
+ *     };
+ *
+ * The fields given to each function are only the ones of the port this driver has claimed (never 0), and port_fields
+ * are all of them. A driver can fill in another driver's fields along with its own if it's cheaper (e.g. the battery
+ * scanned with the AC current), so collect() skips any of its fields that are already valid.
+ *
+ * The registry calls the drivers in its list order, with every call resolved at compile time: no virtual calls, and
+ * a driver left out of the list isn't called. Each sensor object is only reached through its driver (a function-local
+ * static in SensorHelper.cpp, with no global constructor), so the linker's --gc-sections drops an unlisted driver's
+ * code along with its sensor library.
+ *
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright (c) 2021 Kalina Knight - MIT License
+ */
+
+#include "PortSchema.h" /**< Go here for portSchema definitions. */
+
+#define CURRENT_SENSOR_WARM_UP_MS 1000 // Time the current sensor takes to settle after being powered on [ms]
+
+/**
+ * @brief Compile-time list of sensor drivers, see the top of this file for what a driver is.
+ * Earlier drivers take priority: each one claims the fields of the port it provides that an earlier one hasn't, and
+ * if its init() fails they're offered to the drivers after it. Readings are started in list order, then collected in
+ * list order once all are started, so drivers that convert in the background (the RAK1906) go last and convert while
+ * the others are read.
+ */
+template <typename... Drivers> struct sensorDriverList;
+
+/** @brief End of the list. */
+template <> struct sensorDriverList<> {
+    static constexpr uint16_t FIELDS = 0;
+
+    static inline uint16_t init(uint16_t fields) { return fields; };
+    static inline uint16_t claimedFields(void) { return 0; };
+    static inline uint32_t powerOn(uint16_t) { return 0; };
+    static inline void powerOff(uint16_t) {};
+    static inline void start(uint16_t) {};
+    static inline void collect(uint16_t, uint16_t, sensorData *) {};
+};
+
+template <typename Driver, typename... Others> struct sensorDriverList<Driver, Others...> {
+    typedef sensorDriverList<Others...> next;
+
+    /** @brief Every field the drivers of the list can provide. */
+    static constexpr uint16_t FIELDS = Driver::FIELDS | next::FIELDS;
+
+    /** @brief Fields this driver has claimed in init(). */
+    static uint16_t claimed;
+
+    /**
+     * @brief Initialises the drivers needed for the fields, each claiming the ones it provides (see above).
+     * @param fields Fields of the port.
+     * @return Fields no driver could claim, 0 if all of them were.
+     */
+    static inline uint16_t init(uint16_t fields) {
+        uint16_t wanted = fields & Driver::FIELDS;
+        claimed = ((wanted != 0) && Driver::init(wanted)) ? wanted : 0;
+        return next::init(fields & ~claimed);
+    };
+
+    /**
+     * @brief Get the fields claimed by every driver.
+     * @return Fields the drivers will read.
+     */
+    static inline uint16_t claimedFields(void) { return claimed | next::claimedFields(); };
+
+    /**
+     * @brief Powers on the drivers that read the fields.
+     * @param fields Fields of the port.
+     * @return Time until they can all be read [ms], the longest warm-up of those that were off.
+     */
+    static inline uint32_t powerOn(uint16_t fields) {
+        uint32_t warm_up_ms = 0;
+        if ((fields & claimed) && Driver::powerOn(fields & claimed)) {
+            warm_up_ms = Driver::WARM_UP_MS;
+        }
+        uint32_t others_ms = next::powerOn(fields);
+        return (warm_up_ms > others_ms) ? warm_up_ms : others_ms;
+    };
+
+    /**
+     * @brief Powers off the drivers that read the fields.
+     * @param fields Fields of the port.
+     */
+    static inline void powerOff(uint16_t fields) {
+        if (fields & claimed) {
+            Driver::powerOff(fields & claimed);
+        }
+        next::powerOff(fields);
+    };
+
+    /**
+     * @brief Starts a reading of the drivers that read the fields.
+     * @param fields Fields of the port.
+     */
+    static inline void start(uint16_t fields) {
+        if (fields & claimed) {
+            Driver::start(fields & claimed);
+        }
+        next::start(fields);
+    };
+
+    /**
+     * @brief Collects the readings of the drivers that read the fields.
+     * @param fields Fields of the port.
+     * @param data Sensor data to fill in.
+     */
+    static inline void collect(uint16_t fields, sensorData *data) { collect(fields, fields, data); };
+
+    /**
+     * @brief collect() of this driver on, passing on all of the port's fields.
+     */
+    static inline void collect(uint16_t fields, uint16_t port_fields, sensorData *data) {
+        if (fields & claimed) {
+            Driver::collect(fields & claimed, port_fields, data);
+        }
+        next::collect(fields, port_fields, data);
+    };
+};
+
+template <typename Driver, typename... Others> uint16_t sensorDriverList<Driver, Others...>::claimed = 0;
+
+/** @brief Current sensor (HSTS016L) on the ADC: the DC current, AC current & its harmonics. */
+struct currentDriver {
+    static constexpr uint16_t FIELDS = SEND_CURRENT_SENSOR | SEND_AC_CURRENT | SEND_HARMONICS | SEND_THD;
+    static constexpr uint32_t WARM_UP_MS = CURRENT_SENSOR_WARM_UP_MS;
+
+    static bool init(uint16_t fields);
+    static bool powerOn(uint16_t fields);
+    static void powerOff(uint16_t fields);
+    static void start(uint16_t fields);
+    static void collect(uint16_t fields, uint16_t port_fields, sensorData *data);
+};
+
+/** @brief Battery voltage on the ADC. */
+struct batteryDriver {
+    static constexpr uint16_t FIELDS = SEND_BATTERY_VOLTAGE;
+    static constexpr uint32_t WARM_UP_MS = 0;
+
+    static bool init(uint16_t fields);
+    static bool powerOn(uint16_t fields);
+    static void powerOff(uint16_t fields);
+    static void start(uint16_t fields);
+    static void collect(uint16_t fields, uint16_t port_fields, sensorData *data);
+};
+
+/** @brief RAK1906 (BME680) on the I2C bus: temperature, humidity, air pressure & gas resistance. */
+struct rak1906Driver {
+    static constexpr uint16_t FIELDS =
+        SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY | SEND_AIR_PRESSURE | SEND_GAS_RESISTANCE;
+    static constexpr uint32_t WARM_UP_MS = 0;
+
+    static bool init(uint16_t fields);
+    static bool powerOn(uint16_t fields);
+    static void powerOff(uint16_t fields);
+    static void start(uint16_t fields);
+    static void collect(uint16_t fields, uint16_t port_fields, sensorData *data);
+};
+
+/** @brief RAK1901 (SHTC3) on the I2C bus: temperature & humidity. */
+struct rak1901Driver {
+    static constexpr uint16_t FIELDS = SEND_TEMPERATURE | SEND_RELATIVE_HUMIDITY;
+    static constexpr uint32_t WARM_UP_MS = 0;
+
+    static bool init(uint16_t fields);
+    static bool powerOn(uint16_t fields);
+    static void powerOff(uint16_t fields);
+    static void start(uint16_t fields);
+    static void collect(uint16_t fields, uint16_t port_fields, sensorData *data);
+};
+
+/**
+ * @brief The sensor drivers built in, in order of priority (see sensorDriverList).
+ * The RAK1906 has the larger sensor array so it's preferred for the temperature & humidity, the RAK1901 takes them if
+ * there's no RAK1906 plugged in (its init() fails). Remove the drivers of sensors the application never uses, so they
+ * aren't linked in, and add new ones here.
+ */
+typedef sensorDriverList<currentDriver, batteryDriver, rak1906Driver, rak1901Driver> sensorDrivers;
+
+#endif // SENSOR_DRIVERS_H
@@ -1,169 +1,276 @@
 #include "SensorHelper.h"
 
 /**
- * @brief Temp & Humi Sensor Selection
- * As there are two different sensors that can provide temperature &/or humidity the user must specify which one to use.
- * If both USERAK1901 & USERAK1906 are true then we default to using the RAK1906 as it has the larger sensor array.
+ * @brief Measure with the RAK1901's (SHTC3) low power measurement mode: much shorter measurements, but noisier.
  */
-bool USERAK1901 = false;
-bool USERAK1906 = false;
+const bool RAK1901_LOW_POWER_MODE = false;
 
 /**
- * @brief Sensor object instantiations.
+ * @brief Sensor object instantiations, each only reached through the drivers that use it.
  * NOTE: Instantiation does not equal initialisation of the sensor. The instantiation does not interact with the sensor
  * itself, instead it just creates the memory container for interating with it.
+ * Each object is a function-local static, constructed on first use, so a driver left out of sensorDrivers leaves its
+ * sensor (and its library) unreferenced, and the linker's --gc-sections drops them.
  */
-RAK1901 tempHumiSensor;
-RAK1906 enviroSensor;
-BatteryLevel batLvl;
-CurrentSensor HSTS016LSensor;
+static RAK1901 &tempHumiSensor(void) {
+    static RAK1901 sensor;
+    return sensor;
+}
+static RAK1906 &enviroSensor(void) {
+    static RAK1906 sensor;
+    return sensor;
+}
+static BatteryLevel &batLvl(void) {
+    static BatteryLevel sensor;
+    return sensor;
+}
+static CurrentSensor &HSTS016LSensor(void) {
+    static CurrentSensor sensor;
+    return sensor;
+}
 // GPSClass gps;
 // AnalogSensor analogsensorexample(sensor pin, ADC reference voltage, ADC resolution, ADC oversampling);
 
-bool initSensors(const portSchema *port_settings, bool useRAK1901, bool useRAK1906) {
-    log(LOG_LEVEL::DEBUG, "Initialising sensors...");
+/** @brief Current sensor fields that are measured from the AC current waveform. */
+static const uint16_t WAVEFORM_FIELDS = SEND_AC_CURRENT | SEND_HARMONICS | SEND_THD;
+/** @brief Current sensor fields that need the harmonic analysis of the waveform. */
+static const uint16_t HARMONIC_FIELDS = SEND_HARMONICS | SEND_THD;
+
+/** @brief The current sensor is powered on, it is from ADCInit(). */
+static bool current_sensor_powered = false;
+
+bool currentDriver::init(uint16_t fields) {
+    HSTS016LSensor().ADCInit(INPUT_PULLDOWN);
+    current_sensor_powered = true;
+    // the saved calibration is reloaded if it's still good, saving the wait & samples of recalibrating
+    if (HSTS016LSensor().currentSensorCalibrationMode() && !HSTS016LSensor().restoreZeroCurrentCalibration()) {
+        log(LOG_LEVEL::INFO, "Calibration for zero current about to start in 3 seconds.");
+        delay(3000);
+        HSTS016LSensor().zeroCurrentOffsetCalibration();
+        delay(500);
+        log(LOG_LEVEL::INFO, "Calibration for zero current finsihed.");
+    }
+    return true;
+}
 
-    if (useRAK1901 && useRAK1906) {
-        log(LOG_LEVEL::WARN, "Cannot use both SHTC3(RAK1901) & BME680(RAK1906). The RAK1906 will be used by default.");
-        USERAK1906 = useRAK1906;
-        USERAK1901 = false;
-    } else {
-        USERAK1901 = useRAK1901;
-        USERAK1906 = useRAK1906;
-    }
-
-    // battery voltage setup
-    if (port_settings->sendBatteryVoltage) {
-        batLvl.ADCInit();
-    }
-
-    // current sensor setup
-    if (port_settings->sendCurrentSensor) {
-        HSTS016LSensor.ADCInit(INPUT_PULLDOWN);
-        if (HSTS016LSensor.currentSensorCalibrationMode()) {
-            log(LOG_LEVEL::INFO, "Calibration for zero current about to start in 3 seconds.");
-            delay(3000);
-            HSTS016LSensor.zeroCurrentOffsetCalibration();
-            delay(500);
-            log(LOG_LEVEL::INFO, "Calibration for zero current finsihed.");
+bool currentDriver::powerOn(uint16_t fields) {
+    if (current_sensor_powered) {
+        return false;
+    }
+    HSTS016LSensor().PowerOn();
+    current_sensor_powered = true;
+    return true;
+}
+
+void currentDriver::powerOff(uint16_t fields) {
+    HSTS016LSensor().PowerOff();
+    current_sensor_powered = false;
+}
+
+void currentDriver::start(uint16_t fields) {}
+
+void currentDriver::collect(uint16_t fields, uint16_t port_fields, sensorData *data) {
+    // the AC current also measures the DC mean, so both come from the same samples when it's sent
+    currentWaveform waveform = {};
+    bool has_waveform = false;
+    if (fields & WAVEFORM_FIELDS) {
+        // the acquisition lasts whole mains cycles whatever is in it, so the battery is scanned along with it
+        harmonicAnalysis harmonics;
+        bool analyse_harmonics = (fields & HARMONIC_FIELDS);
+        analogScanGroup group = HSTS016LSensor().rmsScanGroup(analyse_harmonics ? &harmonics : nullptr);
+        if (port_fields & SEND_BATTERY_VOLTAGE) {
+            group.sensors[group.n_sensors++] = &batLvl();
         }
-        
-    }
-
-    // 1906 or 1901 setup
-    if (port_settings->sendTemperature || port_settings->sendRelativeHumidity || port_settings->sendAirPressure ||
-        port_settings->sendGasResistance) {
-        if (USERAK1906) {
-            // Environmental (RAK1906) sensor setup
-            initRAK1906Sensors init_sensors = {
-                port_settings->sendTemperature,
-                port_settings->sendRelativeHumidity,
-                port_settings->sendAirPressure,
-                port_settings->sendGasResistance,
-            };
-            if (!enviroSensor.init(&init_sensors)) {
-                log(LOG_LEVEL::ERROR, "Unable to initialise the RAK1906.");
-                return false;
-            }
-        } else if (USERAK1901) {
-            if (port_settings->sendAirPressure || port_settings->sendGasResistance) {
-                log(LOG_LEVEL::ERROR, "The RAK1901 sensor cannot provide air pressure or gas resistance.");
-                return false;
-            } else if (port_settings->sendTemperature || port_settings->sendRelativeHumidity) {
-                // Temperature and humidity (tempHumiSensor) sensor setup
-                if (!tempHumiSensor.init()) {
-                    log(LOG_LEVEL::ERROR, "Unable to initialise the RAK1901.");
-                    return false;
-                }
+        adcSampleSums sums[ADC_MAX_SCAN_CHANNELS];
+        has_waveform = AnalogSensor::sampleScanGroup(&group, sums);
+        if (has_waveform) {
+            HSTS016LSensor().waveformFromSums(&sums[0], &waveform, analyse_harmonics ? &harmonics : nullptr);
+            if (group.n_sensors > 1) {
+                data->battery_mv.value = batLvl().sumsToMV(&sums[1]);
+                data->battery_mv.is_valid = true;
             }
         } else {
-            log(LOG_LEVEL::ERROR, "No sensor chosen to read temp/humi/pressure/gas.");
-            return false;
+            log(LOG_LEVEL::WARN, "Unable to acquire the AC current samples.");
         }
-    } else if (USERAK1901 || USERAK1906) {
-        log(LOG_LEVEL::WARN, "Neither a RAK1901 or RAK1906 is required for this port.");
     }
 
-    // if (port_settings->sendLocation) {
-    //     gps.init();
-    // }
+    if (has_waveform) {
+        data->ac_current.rms = waveform.rms_A;
+        data->ac_current.peak = waveform.peak_A;
+        data->ac_current.is_valid = true;
+        data->harmonics.fundamental = waveform.harmonics_A[0];
+        data->harmonics.h3 = waveform.harmonics_A[1];
+        data->harmonics.h5 = waveform.harmonics_A[2];
+        data->harmonics.h7 = waveform.harmonics_A[3];
+        data->harmonics.is_valid = waveform.harmonics_valid;
+        data->thd.value = waveform.thd_percent;
+        data->thd.is_valid = waveform.thd_valid;
+    }
+    if (fields & SEND_CURRENT_SENSOR) {
+        data->current_A.value = has_waveform ? waveform.mean_A : HSTS016LSensor().readCurrentAmp();
+        // added ADC val
+        data->current_A.ADCval = HSTS016LSensor().ADCaverage;
+        data->current_A.is_valid = true;
+    }
+}
 
+bool batteryDriver::init(uint16_t fields) {
+    batLvl().ADCInit();
     return true;
 }
 
-sensorData getSensorData(const portSchema *port_settings) {
-    sensorData data = {};
+bool batteryDriver::powerOn(uint16_t fields) { return false; }
 
-    if (port_settings->sendBatteryVoltage) {
-        data.battery_mv.value = batLvl.getSensorMV();
-        data.battery_mv.is_valid = true;
+void batteryDriver::powerOff(uint16_t fields) {}
+
+void batteryDriver::start(uint16_t fields) {}
+
+void batteryDriver::collect(uint16_t fields, uint16_t port_fields, sensorData *data) {
+    // already valid if it was scanned with the AC current
+    if (!data->battery_mv.is_valid) {
+        data->battery_mv.value = batLvl().getSensorMV();
+        data->battery_mv.is_valid = true;
     }
+}
 
-    // current sensor 
-    if (port_settings->sendCurrentSensor) {
-        data.current_A.value = HSTS016LSensor.readCurrentAmp();
-        // added ADC val
-        data.current_A.ADCval = HSTS016LSensor.ADCaverage;
-        data.current_A.is_valid = true;
-
-    }
-
-    if (port_settings->sendTemperature || port_settings->sendRelativeHumidity || port_settings->sendAirPressure ||
-        port_settings->sendGasResistance) {
-        if (USERAK1906) {
-            if (enviroSensor.dataReady()) {
-                if (port_settings->sendTemperature) {
-                    data.temperature.value = enviroSensor.getTemperature();
-                    data.temperature.is_valid = true;
-                }
-                if (port_settings->sendRelativeHumidity) {
-                    data.humidity.value = enviroSensor.getHumidity();
-                    data.humidity.is_valid = true;
-                }
-                if (port_settings->sendAirPressure) {
-                    data.pressure.value = enviroSensor.getPressure();
-                    data.pressure.is_valid = true;
-                }
-                if (port_settings->sendGasResistance) {
-                    data.gas_resist.value = enviroSensor.getGasResistance();
-                    data.gas_resist.is_valid = true;
-                }
-            }
-        } else if (USERAK1901) {
-            if (tempHumiSensor.dataReady()) {
-                if (port_settings->sendTemperature) {
-                    data.temperature.value = tempHumiSensor.getTemperature();
-                    data.temperature.is_valid = true;
-                }
-                if (port_settings->sendRelativeHumidity) {
-                    data.humidity.value = tempHumiSensor.getHumidity();
-                    data.humidity.is_valid = true;
-                }
-            }
-        }
+bool rak1906Driver::init(uint16_t fields) {
+    initRAK1906Sensors init_sensors = {
+        (fields & SEND_TEMPERATURE) != 0,
+        (fields & SEND_RELATIVE_HUMIDITY) != 0,
+        (fields & SEND_AIR_PRESSURE) != 0,
+        (fields & SEND_GAS_RESISTANCE) != 0,
+    };
+    if (!enviroSensor().init(&init_sensors)) {
+        log(LOG_LEVEL::WARN, "Unable to initialise the RAK1906.");
+        return false;
     }
+    return true;
+}
+
+// the BME680 goes back to sleep by itself after each forced mode conversion
+bool rak1906Driver::powerOn(uint16_t fields) { return false; }
 
-    // if (port_settings->sendLocation) {
-    //     if (valid gps data) {
-    //         data.location.latitude = gps.getLatitude();
-    //         data.location.longitude = gps.getLongitude();
-    //         data.location.is_valid = true;
-    //     }
-    // }
+void rak1906Driver::powerOff(uint16_t fields) {}
 
+void rak1906Driver::start(uint16_t fields) {
+    // the conversion (with its gas heater) takes the longest, so it converts while the other sensors are read
+    if (!enviroSensor().startReading()) {
+        log(LOG_LEVEL::WARN, "Unable to start the RAK1906 conversion.");
+    }
+}
+
+void rak1906Driver::collect(uint16_t fields, uint16_t port_fields, sensorData *data) {
+    // only waits for whatever is left of the conversion
+    if (!enviroSensor().collectReading()) {
+        return;
+    }
+    if (fields & SEND_TEMPERATURE) {
+        data->temperature.value = enviroSensor().getTemperature();
+        data->temperature.is_valid = true;
+    }
+    if (fields & SEND_RELATIVE_HUMIDITY) {
+        data->humidity.value = enviroSensor().getHumidity();
+        data->humidity.is_valid = true;
+    }
+    if (fields & SEND_AIR_PRESSURE) {
+        data->pressure.value = enviroSensor().getPressure();
+        data->pressure.is_valid = true;
+    }
+    if (fields & SEND_GAS_RESISTANCE) {
+        // the gas heater doesn't run on every reading, it's stale (so invalid) in between
+        data->gas_resist.value = enviroSensor().getGasResistance();
+        data->gas_resist.is_valid = enviroSensor().gasMeasured();
+    }
+}
+
+bool rak1901Driver::init(uint16_t fields) {
+    tempHumiSensor().low_power_mode = RAK1901_LOW_POWER_MODE;
+    if (!tempHumiSensor().init()) {
+        log(LOG_LEVEL::WARN, "Unable to initialise the RAK1901.");
+        return false;
+    }
+    return true;
+}
+
+// the SHTC3 is put to sleep after each reading
+bool rak1901Driver::powerOn(uint16_t fields) { return false; }
+
+void rak1901Driver::powerOff(uint16_t fields) {}
+
+void rak1901Driver::start(uint16_t fields) {
+    if (!tempHumiSensor().startReading()) {
+        log(LOG_LEVEL::WARN, "Unable to start the RAK1901 measurement.");
+    }
+}
+
+void rak1901Driver::collect(uint16_t fields, uint16_t port_fields, sensorData *data) {
+    if (!tempHumiSensor().collectReading()) {
+        return;
+    }
+    if (fields & SEND_TEMPERATURE) {
+        data->temperature.value = tempHumiSensor().getTemperature();
+        data->temperature.is_valid = true;
+    }
+    if (fields & SEND_RELATIVE_HUMIDITY) {
+        data->humidity.value = tempHumiSensor().getHumidity();
+        data->humidity.is_valid = true;
+    }
+}
+
+bool initSensors(const portSchema *port_settings) {
+    log(LOG_LEVEL::DEBUG, "Initialising sensors...");
+
+    uint16_t unclaimed = sensorDrivers::init(port_settings->sensor_mask);
+    if (unclaimed & sensorDrivers::FIELDS) {
+        log(LOG_LEVEL::ERROR, "No sensor could be initialised for fields 0x%04X of port %d.",
+            unclaimed & sensorDrivers::FIELDS, port_settings->port_number);
+        return false;
+    }
+    if (unclaimed) {
+        // e.g. the location, there is no GPS driver yet
+        log(LOG_LEVEL::WARN, "No sensor driver for fields 0x%04X of port %d, they will be sent invalid.", unclaimed,
+            port_settings->port_number);
+    }
+    return true;
+}
+
+sensorData getSensorData(const portSchema *port_settings) {
+    sensorData data = {};
+    uint32_t start_ms = millis();
+
+    // fields of a driver that wasn't initialised for them, e.g. the port wasn't given to initSensors()
+    uint16_t unclaimed = port_settings->sensor_mask & sensorDrivers::FIELDS & ~sensorDrivers::claimedFields();
+    if (unclaimed) {
+        log(LOG_LEVEL::WARN, "Fields 0x%04X of port %d weren't initialised, they will be sent invalid.", unclaimed,
+            port_settings->port_number);
+    }
+
+    sensorDrivers::start(port_settings->sensor_mask);
+    sensorDrivers::collect(port_settings->sensor_mask, &data);
+
+    log(LOG_LEVEL::DEBUG, "Sensor data read in %lu ms.", millis() - start_ms);
+    logI2cStats();
     return data;
 }
 
-void SensorPowerOff(const portSchema *port_settings) {
-        // current sensor 
-    if (port_settings->sendCurrentSensor) {
-        HSTS016LSensor.PowerOff();
+void SensorPowerOff(const portSchema *port_settings, bool keep_current_sensor) {
+    uint16_t fields = port_settings->sensor_mask;
+    if (keep_current_sensor) {
+        fields &= ~currentDriver::FIELDS;
     }
+    sensorDrivers::powerOff(fields);
 }
 
-void SensorPowerOn(const portSchema *port_settings) {
-    // current sensor 
-    if (port_settings->sendCurrentSensor) {
-        HSTS016LSensor.PowerOn();
+uint32_t SensorPowerOn(const portSchema *port_settings) { return sensorDrivers::powerOn(port_settings->sensor_mask); }
+
+bool startCurrentEventMonitor(const portSchema *port_settings, adcLimitHandler handler) {
+    if (!(port_settings->sensor_mask & sensorDrivers::claimedFields() & currentDriver::FIELDS)) {
+        log(LOG_LEVEL::WARN, "Current events need a port with the current sensor.");
+        return false;
     }
-}
\ No newline at end of file
+    return HSTS016LSensor().startEventMonitor(handler);
+}
+
+void stopCurrentEventMonitor(void) {
+    stopAdcLimitMonitor();
+}
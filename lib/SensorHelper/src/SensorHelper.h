@@ -20,31 +20,60 @@
  */
 
 #include "AnalogSensor.h"   /**< Class to read a sensor using the onboard ADC. Plus BatteryLevel class. */
+#include "I2cBus.h"         /**< Shared I2C bus of the RAK1901 & RAK1906. */
 #include "Logging.h"        /**< Go here to change the logging level for the entire application. */
 #include "PortSchema.h"     /**< Go here for portSchema definitions. */
 #include "RAK1901_helper.h" /**< Wrapper for SHTC3 library. */
 #include "RAK1906_helper.h" /**< Wrapper for BME680 library. */
+#include "SensorDrivers.h"  /**< Go here to choose the sensors built in, or add a driver for a new sensor. */
 
 /**
- * @brief Initialise the given sensors based on the port schema.
- * As there are two sensors (1901 & 1906) that can provide temp & humi data, a sensor must be specified.
+ * @brief Initialise the sensors needed by the port schema, using the drivers in sensorDrivers (see SensorDrivers.h).
+ * As there are two sensors (1901 & 1906) that can provide temp & humi data, the first one in sensorDrivers that
+ * initialises provides them.
+ * Each driver only reads the fields it was initialised for, so give it every port the app reads, combined with
+ * portSchema::operator+ (e.g. payload_port + event_port).
  * @param port_settings Pointer to port schema for this app.
- * @param useRAK1901
- * @param useRAK1906
- * @return True if successful. False if not.
+ * @return True if successful. False if a field of the port has a driver, but none of them could be initialised.
  *
  */
-bool initSensors(const portSchema *port_settings, bool useRAK1901, bool useRAK1906);
+bool initSensors(const portSchema *port_settings);
 
 /**
- * @brief Get the sensor data.
+ * @brief Get the sensor data, from only the drivers the port needs.
+ * Every driver's reading is started before any are collected, so the slower ones convert while the others are read.
  * @param port_settings Pointer to port schema for this app.
  * @return The sensor data in sensorData struct format.
  */
 sensorData getSensorData(const portSchema *port_settings);
 
-void SensorPowerOff(const portSchema *port_settings);
+/**
+ * @brief Powers off the sensors used by the port, e.g. before sleeping.
+ * @param port_settings Pointer to port schema for this app.
+ * @param keep_current_sensor Leave the current sensor powered, e.g. for startCurrentEventMonitor() (Default: false).
+ */
+void SensorPowerOff(const portSchema *port_settings, bool keep_current_sensor = false);
+
+/**
+ * @brief Powers on the sensors used by the port, e.g. after sleeping.
+ * @param port_settings Pointer to port schema for this app.
+ * @return Time to wait before reading them [ms], the longest warm-up of the sensors that were off.
+ */
+uint32_t SensorPowerOn(const portSchema *port_settings);
 
-void SensorPowerOn(const portSchema *port_settings);
+/**
+ * @brief Watches the current sensor in the background while the device sleeps, calling the handler (from the SAADC
+ * interrupt) the first time a sample is outside its event thresholds, see CurrentSensor::startEventMonitor().
+ * Must be stopped with stopCurrentEventMonitor() before the sensors are read again.
+ * @param port_settings Pointer to port schema for this app.
+ * @param handler Called with true if the current went above CurrentSensor::event_high_A, false if below event_low_A.
+ * @return True if started. False if the port doesn't use the current sensor or the monitor can't start.
+ */
+bool startCurrentEventMonitor(const portSchema *port_settings, adcLimitHandler handler);
+
+/**
+ * @brief Stops watching the current sensor, if startCurrentEventMonitor() was started and hasn't been triggered yet.
+ */
+void stopCurrentEventMonitor(void);
 
 
@@ -15,6 +15,7 @@
 #include "LoRaWAN_functs.h" /**< Go here to change the LoRaWAN settings. */
 #include "Logging.h"        /**< Go here to change the logging level for the entire application. */
 #include "OTAA_keys.h"      /**< Go here to set the OTAA keys (See LoRaWAN_functs README). */
+#include "PayloadPlanner.h" /**< Go here to see how payloads too long for the datarate are handled. */
 #include "PortSchema.h"     /**< Go here to see existing and define new sensor/port schemas. */
 #include "SensorHelper.h"   /**< Go here to add code for init-ing and reading new additional sensors. */
 
@@ -29,24 +30,37 @@ static void appTimerTimeoutHandler(TimerHandle_t unused);
 // TODO: not sure about pdFalse
 static SemaphoreHandle_t semaphore_handle = NULL; /**< Semaphore used by events to wake up loop task. */
 enum class EVENT_TASK {
-    SLEEP,        /**< Use semaphore take to "sleep" in a low power state. */
-    SEND_PAYLOAD, /**< Send a sensor reading payload. */
+    SLEEP,         /**< Use semaphore take to "sleep" in a low power state. */
+    SEND_PAYLOAD,  /**< Send a sensor reading payload. */
+    CURRENT_EVENT, /**< Send an exception report, the current crossed one of its event thresholds. */
 };
 static EVENT_TASK current_task = EVENT_TASK::SLEEP; /**< Current task of the device, similar to a finite
                                                        state machine
                                                        design. Used in loop() to switch between tasks. */
 
+// CURRENT EVENTS - wake up between payloads when the current crosses CurrentSensor::event_low_A or event_high_A
+const bool current_event_mode = false; /**< Watch for current events while asleep, keeps the current sensor powered. */
+const uint32_t current_event_holdoff_ms = 60000; /**< Least time between exception reports, so a lasting event isn't
+                                                    reported over and over. */
+static portSchema event_port = PORT13;     /**< Frame data port of the exception report: battery + current + AC. */
+static uint32_t last_event_ms = 0;         /**< millis() of the last current event. */
+static bool current_event_reported = false; /**< True once there's been a current event. */
+static volatile bool event_above_high = false; /**< True if the last current event was above event_high_A. */
+// forward declaration
+static void currentEventHandler(bool above_high, void *unused);
+
 // PAYLOAD ENCODING
 uint8_t payload_buffer[PAYLOAD_BUFFER_SIZE] = {};                /**< Buffer that payload data is placed in. */
 lmh_app_data_t lorawan_payload = { payload_buffer, 0, 0, 0, 0 }; /**< Struct that passes the payload buffer and
                                                                     relevant params for a LoRaWAN frame. */
 // forward declaration
-void fillPayload(void);
+void fillPayload(const portSchema *port);
 
 // PORT/SENSOR SELECTION
 // The chosen port determines the sensor data included in the payload - see
 // PortSchema.h
 static portSchema payload_port = PORT11; /**< Frame data port. E.g. port 3: battery voltage + temperature */
+static portSchema sensor_ports = {};     /**< Every sensor field read by the app: payload_port (+ event_port). */
 
 /**
  * @brief Setup code runs once on reset/startup.
@@ -63,9 +77,9 @@ void setup() {
     // Create the semaphore that will enable low power 'sleep'
     semaphore_handle = xSemaphoreCreateBinary();
 
-    // Init sensors according to payload_port selected
-    // Neither 1901 or 1906 is needed for PORT1
-    if (!initSensors(&payload_port, false, false)) {
+    // Init sensors according to payload_port selected, and event_port for the exception reports
+    sensor_ports = current_event_mode ? (payload_port + event_port) : payload_port;
+    if (!initSensors(&sensor_ports)) {
         // error init-ing sensors
         delay(1000);
         return;
@@ -100,13 +114,31 @@ void loop() {
             // (or another function). It will wait (up to portMAX_DELAY ticks) for the
             // semaphore_handle semaphore to be given.
 
-            SensorPowerOff(&payload_port);
-            delay(500); // not sure if need
-            
-            xSemaphoreTake(semaphore_handle, portMAX_DELAY);
+            {
+                // watch the current while asleep, unless there was a current event within the holdoff, then wake
+                // up again once the holdoff is over to start watching again
+                uint32_t since_event_ms = millis() - last_event_ms;
+                bool holdoff = current_event_reported && (since_event_ms < current_event_holdoff_ms);
+
+                // the current sensor only stays powered while it's being watched
+                SensorPowerOff(&sensor_ports, current_event_mode && !holdoff);
+                delay(500); // not sure if need
+
+                bool watching = current_event_mode && !holdoff &&
+                                startCurrentEventMonitor(&sensor_ports, currentEventHandler);
+                TickType_t sleep_ticks = (current_event_mode && holdoff)
+                                             ? pdMS_TO_TICKS(current_event_holdoff_ms - since_event_ms)
+                                             : portMAX_DELAY;
+
+                xSemaphoreTake(semaphore_handle, sleep_ticks);
+
+                if (watching) {
+                    stopCurrentEventMonitor();
+                }
+            }
 
-            SensorPowerOn(&payload_port);
-            delay(1000); // wait 1 second to turn on
+            // wait for the sensors to turn on, no wait if they were left on (e.g. the current sensor in event mode)
+            delay(SensorPowerOn(&sensor_ports));
 
             // This point is only reached if the semaphore was able to be taken or the
             // function timed out. If the semaphore was able to be taken, then the
@@ -121,9 +153,11 @@ void loop() {
             if (isLoRaWANConnected()) {
                 log(LOG_LEVEL::DEBUG, "Send payload");
                 // fill lora data buffer
-                fillPayload();
-                // send data
-                sendLoRaWANFrame(&lorawan_payload);
+                fillPayload(&payload_port);
+                // send data, if any fits the datarate
+                if (lorawan_payload.buffsize > 0) {
+                    sendLoRaWANFrame(&lorawan_payload);
+                }
             } else {
                 log(LOG_LEVEL::DEBUG, "LoRaWAN not connected. Try again later.");
             }
@@ -131,6 +165,21 @@ void loop() {
             current_task = EVENT_TASK::SLEEP;
             break;
 
+        case EVENT_TASK::CURRENT_EVENT:
+            log(LOG_LEVEL::INFO, "Current event: %s threshold.", event_above_high ? "above the high" : "below the low");
+            if (isLoRaWANConnected()) {
+                // the exception report: a reading of the current (with its AC RMS & peak) straight after the event
+                fillPayload(&event_port);
+                if (lorawan_payload.buffsize > 0) {
+                    sendLoRaWANFrame(&lorawan_payload);
+                }
+            } else {
+                log(LOG_LEVEL::DEBUG, "LoRaWAN not connected. Exception report not sent.");
+            }
+            // go back to 'sleep'
+            current_task = EVENT_TASK::SLEEP;
+            break;
+
         default:
             // just in case there's an unknown current_task, go to 'sleep'
             current_task = EVENT_TASK::SLEEP;
@@ -159,15 +208,30 @@ void appTimerTimeoutHandler(TimerHandle_t unused) {
     xSemaphoreGiveFromISR(semaphore_handle, pdFALSE);
 }
 
+/**
+ * @brief Function for handling a current event, from the SAADC interrupt.
+ * Sets the current_task to CURRENT_EVENT and then 'wakes' the device by giving the semaphore, like
+ * appTimerTimeoutHandler(). A payload due at the same time is skipped, the exception report has the same readings.
+ */
+void currentEventHandler(bool above_high, void *unused) {
+    event_above_high = above_high;
+    last_event_ms = millis();
+    current_event_reported = true;
+    current_task = EVENT_TASK::CURRENT_EVENT;
+    // Give the semaphore, so the loop task can take it and wake up
+    xSemaphoreGiveFromISR(semaphore_handle, pdFALSE);
+}
+
 /**
  * @brief Gets the sensor data, then fills payload_buffer with the encoded data
  * ready for sending via LoRaWAN. Follows the portSchema specified in
  * PortSchema.h.
+ * @param port Port to fill the payload for, e.g. payload_port.
  */
-void fillPayload(void) {
+void fillPayload(const portSchema *port) {
     // get the sensor data
     sensorData sensor_data = {};
-    sensor_data = getSensorData(&payload_port);
+    sensor_data = getSensorData(port);
 
     // log sensor data
     log(LOG_LEVEL::INFO,
@@ -182,10 +246,16 @@ void fillPayload(void) {
     // reset the payload
     memset(payload_buffer, 0, sizeof(payload_buffer));
     lorawan_payload.buffsize = 0;
-    lorawan_payload.port = payload_port.port_number;
+
+    // if the port doesn't fit the current datarate send a smaller port with as many of its sensors as fit
+    payloadPlan plan = planPayload(*port, getLoRaWANMaxPayloadSize(), PLAN_FALLBACK::SMALLER_PORT);
+    if (plan.plan == PAYLOAD_PLAN::NONE) {
+        return;
+    }
+    lorawan_payload.port = plan.port.port_number;
 
     // encode the sensor data to lorawan_payload
-    lorawan_payload.buffsize = payload_port.encodeSensorDataToPayload(&sensor_data, payload_buffer);
+    lorawan_payload.buffsize = plan.port.encodeSensorDataToPayload(&sensor_data, payload_buffer);
 
     // log the encoded bytes
     char encoded_payload_bytes[3 * PAYLOAD_BUFFER_SIZE] = {};